@@ -0,0 +1,62 @@
+#include "catalogue_builder.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace transport {
+
+using namespace std::literals;
+
+CatalogueBuilder::CatalogueBuilder(size_t stop_count, size_t bus_count, size_t distance_count) {
+    catalogue_.Reserve(stop_count, bus_count, distance_count);
+    distances_.reserve(distance_count);
+    buses_.reserve(bus_count);
+}
+
+CatalogueBuilder& CatalogueBuilder::AddStop(std::string_view name, geo::Coordinates coordinates) {
+    catalogue_.AddStop(name, coordinates);
+    return *this;
+}
+
+CatalogueBuilder& CatalogueBuilder::AddDistance(std::string_view from, std::string_view to, int distance) {
+    distances_.push_back({ catalogue_.InternName(from), catalogue_.InternName(to), distance });
+    return *this;
+}
+
+CatalogueBuilder& CatalogueBuilder::AddBus(std::string_view number, const std::vector<std::string_view>& stops, bool is_circle) {
+    buses_.push_back({ catalogue_.InternName(number), bus_stops_.size(), stops.size(), is_circle });
+    for (const std::string_view stop : stops) {
+        bus_stops_.push_back(catalogue_.InternName(stop));
+    }
+    return *this;
+}
+
+TransportCatalogue CatalogueBuilder::Build() {
+    for (const auto& [from, to, distance] : distances_) {
+        catalogue_.SetDistance(RequireStop(from, "Road distance from"sv, from), RequireStop(to, "Road distance from"sv, from), distance);
+    }
+
+    std::vector<const Stop*> stops;
+    for (const auto& bus : buses_) {
+        stops.resize(bus.stop_count);
+        for (size_t i = 0; i < bus.stop_count; ++i) {
+            stops[i] = RequireStop(bus_stops_[bus.first_stop + i], "Bus"sv, bus.number);
+        }
+        catalogue_.AddRoute(bus.number, stops, bus.is_circle);
+    }
+
+    distances_.clear();
+    buses_.clear();
+    bus_stops_.clear();
+    return std::move(catalogue_);
+}
+
+const Stop* CatalogueBuilder::RequireStop(std::string_view name, std::string_view kind, std::string_view owner) const {
+    const Stop* stop = catalogue_.FindStop(name);
+    if (stop == nullptr) {
+        throw std::invalid_argument(std::string(kind) + " '"s + std::string(owner) + "' refers to unknown stop '"s + std::string(name) + "'"s);
+    }
+    return stop;
+}
+
+} // namespace transport
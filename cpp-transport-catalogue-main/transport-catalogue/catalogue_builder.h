@@ -0,0 +1,54 @@
+#pragma once
+
+#include "geo.h"
+#include "transport_catalogue.h"
+
+#include <string_view>
+#include <vector>
+
+namespace transport {
+
+/*
+    * Пакетная загрузка каталога: если число остановок, маршрутов и расстояний известно заранее,
+    * словари и хранилище имён резервируются один раз.
+    * Расстояния и маршруты копятся и добавляются в Build после всех остановок, поэтому порядок
+    * объектов во входных данных не важен. Имена сразу попадают в хранилище имён каталога,
+    * так что переданные строки могут быть временными. Индексы затем строит TransportCatalogue::Finalize
+    */
+class CatalogueBuilder {
+public:
+    CatalogueBuilder() = default;
+    CatalogueBuilder(size_t stop_count, size_t bus_count, size_t distance_count);
+
+    CatalogueBuilder& AddStop(std::string_view name, geo::Coordinates coordinates);
+    CatalogueBuilder& AddDistance(std::string_view from, std::string_view to, int distance);
+    CatalogueBuilder& AddBus(std::string_view number, const std::vector<std::string_view>& stops, bool is_circle);
+
+    // Бросает std::invalid_argument, если расстояние или маршрут ссылается на неизвестную остановку
+    TransportCatalogue Build();
+
+private:
+    struct PendingDistance {
+        std::string_view from;
+        std::string_view to;
+        int distance;
+    };
+
+    struct PendingBus {
+        std::string_view number;
+        size_t first_stop;
+        size_t stop_count;
+        bool is_circle;
+    };
+
+    // Сообщение об ошибке называет объект, который ссылается на остановку: "<kind> '<owner>'"
+    const Stop* RequireStop(std::string_view name, std::string_view kind, std::string_view owner) const;
+
+    TransportCatalogue catalogue_;
+    std::vector<PendingDistance> distances_;
+    std::vector<PendingBus> buses_;
+    // Остановки всех маршрутов подряд, маршрут ссылается на свой отрезок
+    std::vector<std::string_view> bus_stops_;
+};
+
+} // namespace transport
@@ -1,26 +1,38 @@
 #pragma once
 
 #include "geo.h"
+#include "ranges.h"
 
-#include <string>
+#include <cstdint>
+#include <string_view>
+#include <utility>
 #include <vector>
-#include <set>
 #include <unordered_map>
 
 namespace transport {
 
 struct Stop {
-    std::string name;
+    std::string_view name;
     geo::Coordinates coordinates;
-    std::set<std::string> buses_by_stop;
+    // Отсортированные номера маршрутов в порядке GetSortedAllBuses, проходящих через остановку
+    std::vector<uint32_t> bus_ids;
 };
 
 struct Bus {
-    std::string number;
+    std::string_view number;
     std::vector<const Stop*> stops;
     bool is_circle;
+    // Накопленные длины от первой остановки: по дорогам в прямом и обратном направлении и по прямой
+    std::vector<int> forward_distances;
+    std::vector<int> backward_distances;
+    std::vector<double> geo_distances;
+    // Все вхождения остановок в маршрут парами (остановка, позиция), отсортированные по остановке, затем по позиции
+    std::vector<std::pair<const Stop*, uint32_t>> stop_positions;
 };
 
+using BusesRange = ranges::Range<std::vector<const Bus*>::const_iterator>;
+using StopsRange = ranges::Range<std::vector<const Stop*>::const_iterator>;
+
 struct BusStat {
     size_t stops_count;
     size_t unique_stops_count;
@@ -28,4 +40,10 @@ struct BusStat {
     double curvature;
 };
 
+struct RouteSegmentStat {
+    size_t span_count;
+    int route_length;
+    double geographic_length;
+};
+
 } // namespace transport
\ No newline at end of file
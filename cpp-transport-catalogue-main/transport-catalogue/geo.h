@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
@@ -15,6 +16,31 @@ struct Coordinates {
     }
 };
 
+// Прямоугольник в координатах: min — юго-западный угол, max — северо-восточный
+struct BoundingBox {
+    Coordinates min;
+    Coordinates max;
+
+    bool Contains(Coordinates point) const {
+        return min.lat <= point.lat && point.lat <= max.lat && min.lng <= point.lng && point.lng <= max.lng;
+    }
+    bool Intersects(const BoundingBox& other) const {
+        return min.lat <= other.max.lat && other.min.lat <= max.lat && min.lng <= other.max.lng && other.min.lng <= max.lng;
+    }
+    void Extend(const BoundingBox& other) {
+        min = { std::min(min.lat, other.min.lat), std::min(min.lng, other.min.lng) };
+        max = { std::max(max.lat, other.max.lat), std::max(max.lng, other.max.lng) };
+    }
+};
+
+// Наименьший прямоугольник, содержащий обе точки, в каком бы порядке ни были заданы углы
+inline BoundingBox MakeBoundingBox(Coordinates lhs, Coordinates rhs) {
+    return {
+        { std::min(lhs.lat, rhs.lat), std::min(lhs.lng, rhs.lng) },
+        { std::max(lhs.lat, rhs.lat), std::max(lhs.lng, rhs.lng) }
+    };
+}
+
 double ComputeDistance(Coordinates from, Coordinates to);
 
 }  // namespace geo
\ No newline at end of file
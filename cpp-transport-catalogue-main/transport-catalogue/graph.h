@@ -4,7 +4,7 @@
 
 #include <cstdlib>
 #include <vector>
-#include <string>
+#include <string_view>
 
 namespace graph {
 
@@ -13,7 +13,7 @@ using EdgeId = size_t;
 
 template <typename Weight>
 struct Edge {
-    std::string name;
+    std::string_view name;
     size_t quality;
     VertexId from;
     VertexId to;
@@ -1,5 +1,9 @@
 #include "json.h"
+#include "json_scan.h"
+#include "json_writer.h"
 
+#include <charconv>
+#include <cstring>
 #include <iterator>
 
 namespace json {
@@ -11,6 +15,23 @@ using namespace std::literals;
 Node LoadNode(std::istream& input);
 Node LoadString(std::istream& input);
 
+// Целое сначала читается как int, а при переполнении, как и дробное, как double
+Node ConvertNumber(std::string_view text, bool is_int) {
+    const char* begin = text.data();
+    const char* end = text.data() + text.size();
+    if (is_int) {
+        int value = 0;
+        if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc() && ptr == end) {
+            return value;
+        }
+    }
+    double value = 0.0;
+    if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc() && ptr == end) {
+        return value;
+    }
+    throw ParsingError("Failed to convert "s + std::string(text) + " to number"s);
+}
+
 std::string LoadLiteral(std::istream& input) {
     std::string s;
     while (std::isalpha(input.peek())) {
@@ -20,7 +41,7 @@ std::string LoadLiteral(std::istream& input) {
 }
 
 Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+    Array result;
 
     for (char c; input >> c && c != ']';) {
         if (c != ',') {
@@ -39,7 +60,7 @@ Node LoadDict(std::istream& input) {
 
     for (char c; input >> c && c != '}';) {
         if (c == '"') {
-            std::string key = LoadString(input).AsString();
+            std::string key(LoadString(input).AsString());
             if (input >> c && c == ':') {
                 if (dict.find(key) != dict.end()) {
                     throw ParsingError("Duplicate key '"s + key + "' have been found");
@@ -184,22 +205,7 @@ Node LoadNumber(std::istream& input) {
         is_int = false;
     }
 
-    try {
-        if (is_int) {
-            // Ñíà÷àëà ïðîáóåì ïðåîáðàçîâàòü ñòðîêó â int
-            try {
-                return std::stoi(parsed_num);
-            }
-            catch (...) {
-                // Â ñëó÷àå íåóäà÷è, íàïðèìåð, ïðè ïåðåïîëíåíèè
-                // êîä íèæå ïîïðîáóåò ïðåîáðàçîâàòü ñòðîêó â double
-            }
-        }
-        return std::stod(parsed_num);
-    }
-    catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-    }
+    return ConvertNumber(parsed_num, is_int);
 }
 
 Node LoadNode(std::istream& input) {
@@ -234,123 +240,218 @@ Node LoadNode(std::istream& input) {
     }
 }
 
-struct PrintContext {
-    std::ostream& out;
-    int indent_step = 4;
-    int indent = 0;
+// Разбор непрерывного буфера: перемещается указатель, числа читаются через from_chars,
+// контейнеры и строки с экранированием выделяются из арены
+class BufferParser {
+public:
+    BufferParser(const char* begin, const char* end, std::pmr::memory_resource* arena)
+        : pos_(begin)
+        , end_(end)
+        , arena_(arena)
+    {
+    }
 
-    void PrintIndent() const {
-        for (int i = 0; i < indent; ++i) {
-            out.put(' ');
+    Node ParseDocument() {
+        Node root = ParseNode();
+        SkipSpaces();
+        if (pos_ != end_) {
+            throw ParsingError("Unexpected data after JSON value"s);
         }
+        return root;
     }
 
-    PrintContext Indented() const {
-        return { out, indent_step, indent_step + indent };
+private:
+    const char* pos_;
+    const char* end_;
+    std::pmr::memory_resource* arena_;
+
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
     }
-};
 
-void PrintNode(const Node& value, const PrintContext& ctx);
+    static bool IsDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
 
-template <typename Value>
-void PrintValue(const Value& value, const PrintContext& ctx) {
-    ctx.out << value;
-}
+    void SkipSpaces() {
+        while (pos_ != end_ && IsSpace(*pos_)) {
+            ++pos_;
+        }
+    }
 
-void PrintString(const std::string& value, std::ostream& out) {
-    out.put('"');
-    for (const char c : value) {
+    // Возвращает следующий значащий символ и сдвигается за него
+    char NextChar() {
+        SkipSpaces();
+        if (pos_ == end_) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        return *pos_++;
+    }
+
+    Node ParseNode() {
+        const char c = NextChar();
         switch (c) {
-        case '\r':
-            out << "\\r"sv;
-            break;
-        case '\n':
-            out << "\\n"sv;
-            break;
+        case '[':
+            return ParseArray();
+        case '{':
+            return ParseDict();
         case '"':
-            // Ñèìâîëû " è \ âûâîäÿòñÿ êàê \" èëè \\, ñîîòâåòñòâåííî
-            [[fallthrough]];
-        case '\\':
-            out.put('\\');
-            [[fallthrough]];
+            return ParseString();
+        case 't':
+        case 'f':
+        case 'n':
+            --pos_;
+            return ParseLiteral();
         default:
-            out.put(c);
-            break;
+            --pos_;
+            return ParseNumber();
         }
     }
-    out.put('"');
-}
 
-template <>
-void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
-    PrintString(value, ctx.out);
-}
+    Node ParseArray() {
+        Array result(arena_);
+        for (char c = NextChar(); c != ']'; c = NextChar()) {
+            if (c != ',') {
+                --pos_;
+            }
+            result.push_back(ParseNode());
+        }
+        return Node(std::move(result));
+    }
 
-template <>
-void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
-    ctx.out << "null"sv;
-}
+    Node ParseDict() {
+        Dict dict(arena_);
+        for (char c = NextChar(); c != '}'; c = NextChar()) {
+            if (c == '"') {
+                const std::string_view key = ParseString().AsString();
+                if (c = NextChar(); c != ':') {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+                if (!dict.emplace(key, ParseNode()).second) {
+                    throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
+                }
+            }
+            else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        return Node(std::move(dict));
+    }
 
-// Â ñïåöèàëèçàöè øàáëîíà PrintValue äëÿ òèïà bool ïàðàìåòð value ïåðåäà¸òñÿ
-// ïî êîíñòàíòíîé ññûëêå, êàê è â îñíîâíîì øàáëîíå.
-// Â êà÷åñòâå àëüòåðíàòèâû ìîæíî èñïîëüçîâàòü ïåðåãðóçêó:
-// void PrintValue(bool value, const PrintContext& ctx);
-template <>
-void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
-    ctx.out << (value ? "true"sv : "false"sv);
-}
+    Node ParseString() {
+        const char* begin = pos_;
+        pos_ = FindStringSpecial(pos_, end_);
+        if (pos_ == end_) {
+            throw ParsingError("String parsing error"s);
+        }
+        if (*pos_ == '"') {
+            return Node(std::string_view(begin, pos_++ - begin));
+        }
 
-template <>
-void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "[\n"sv;
-    bool first = true;
-    auto inner_ctx = ctx.Indented();
-    for (const Node& node : nodes) {
-        if (first) {
-            first = false;
+        // Строку с экранированием приходится собирать заново, результат копируется в арену.
+        // Участки без особых символов между экранированиями копируются целиком
+        std::string s;
+        while (true) {
+            s.append(begin, pos_);
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error"s);
+            }
+            const char ch = *pos_++;
+            if (ch == '"') {
+                break;
+            }
+            if (ch == '\n' || ch == '\r') {
+                throw ParsingError("Unexpected end of line"s);
+            }
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error"s);
+            }
+            const char escaped_char = *pos_++;
+            switch (escaped_char) {
+            case 'n':
+                s.push_back('\n');
+                break;
+            case 't':
+                s.push_back('\t');
+                break;
+            case 'r':
+                s.push_back('\r');
+                break;
+            case '"':
+                s.push_back('"');
+                break;
+            case '\\':
+                s.push_back('\\');
+                break;
+            default:
+                throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+            }
+            begin = pos_;
+            pos_ = FindStringSpecial(pos_, end_);
         }
-        else {
-            out << ",\n"sv;
+        char* stored = static_cast<char*>(arena_->allocate(std::max<size_t>(s.size(), 1), alignof(char)));
+        std::copy(s.begin(), s.end(), stored);
+        return Node(std::string_view(stored, s.size()));
+    }
+
+    Node ParseLiteral() {
+        const char* begin = pos_;
+        while (pos_ != end_ && ((*pos_ >= 'a' && *pos_ <= 'z') || (*pos_ >= 'A' && *pos_ <= 'Z'))) {
+            ++pos_;
+        }
+        const std::string_view literal(begin, pos_ - begin);
+        if (literal == "true"sv) {
+            return Node{ true };
+        }
+        if (literal == "false"sv) {
+            return Node{ false };
         }
-        inner_ctx.PrintIndent();
-        PrintNode(node, inner_ctx);
+        if (literal == "null"sv) {
+            return Node{ nullptr };
+        }
+        throw ParsingError("Failed to parse '"s + std::string(literal) + "' as literal"s);
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put(']');
-}
 
-template <>
-void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-    std::ostream& out = ctx.out;
-    out << "{\n"sv;
-    bool first = true;
-    auto inner_ctx = ctx.Indented();
-    for (const auto& [key, node] : nodes) {
-        if (first) {
-            first = false;
+    void SkipDigits() {
+        if (pos_ == end_ || !IsDigit(*pos_)) {
+            throw ParsingError("A digit is expected"s);
         }
-        else {
-            out << ",\n"sv;
+        while (pos_ != end_ && IsDigit(*pos_)) {
+            ++pos_;
         }
-        inner_ctx.PrintIndent();
-        PrintString(key, ctx.out);
-        out << ": "sv;
-        PrintNode(node, inner_ctx);
     }
-    out.put('\n');
-    ctx.PrintIndent();
-    out.put('}');
-}
 
-void PrintNode(const Node& node, const PrintContext& ctx) {
-    std::visit(
-        [&ctx](const auto& value) {
-            PrintValue(value, ctx);
-        },
-        node.GetValue());
-}
+    Node ParseNumber() {
+        // Сначала проверяется грамматика JSON, затем найденный отрезок преобразуется целиком
+        const char* begin = pos_;
+        if (pos_ != end_ && *pos_ == '-') {
+            ++pos_;
+        }
+        if (pos_ != end_ && *pos_ == '0') {
+            ++pos_;
+        }
+        else {
+            SkipDigits();
+        }
+
+        bool is_int = true;
+        if (pos_ != end_ && *pos_ == '.') {
+            ++pos_;
+            SkipDigits();
+            is_int = false;
+        }
+        if (pos_ != end_ && (*pos_ == 'e' || *pos_ == 'E')) {
+            ++pos_;
+            if (pos_ != end_ && (*pos_ == '+' || *pos_ == '-')) {
+                ++pos_;
+            }
+            SkipDigits();
+            is_int = false;
+        }
+
+        return ConvertNumber(std::string_view(begin, pos_ - begin), is_int);
+    }
+};
 
 }  // namespace
 
@@ -358,8 +459,31 @@ Document Load(std::istream& input) {
     return Document{ LoadNode(input) };
 }
 
+Document LoadBuffer(std::string buffer) {
+    auto storage = std::make_shared<Document::Storage>(std::move(buffer));
+    const std::string& source = storage->buffer;
+    Node root = BufferParser(source.data(), source.data() + source.size(), &storage->arena).ParseDocument();
+    return Document{ std::move(root), std::move(storage) };
+}
+
+Document LoadBuffer(std::istream& input) {
+    // Вход читается блоками сразу в буфер документа, без промежуточного потока и копии
+    constexpr size_t READ_SIZE = 64 * 1024;
+    std::string buffer;
+    for (;;) {
+        const size_t size = buffer.size();
+        buffer.resize(size + READ_SIZE);
+        const std::streamsize read = input.rdbuf()->sgetn(buffer.data() + size, static_cast<std::streamsize>(READ_SIZE));
+        buffer.resize(size + static_cast<size_t>(read));
+        if (static_cast<size_t>(read) < READ_SIZE) {
+            break;
+        }
+    }
+    return LoadBuffer(std::move(buffer));
+}
+
 void Print(const Document& doc, std::ostream& output) {
-    PrintNode(doc.GetRoot(), PrintContext{ output });
+    Writer(output, { false, 6 }).Value(doc.GetRoot());
 }
 
 } // namespace json
\ No newline at end of file
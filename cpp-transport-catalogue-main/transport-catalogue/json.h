@@ -1,24 +1,79 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace json {
 
 class Node;
-using Dict = std::map<std::string, Node>;
-using Array = std::vector<Node>;
+using Array = std::pmr::vector<Node>;
+
+/*
+    * Словарь JSON: пары ключ-значение лежат подряд в одном векторе, отсортированные по ключу.
+    * Интерфейс повторяет нужную часть std::map: at, count, find, emplace и обход по возрастанию ключей.
+    * Ключи и сами пары выделяются из того же ресурса памяти, что и словарь
+    */
+class Dict {
+public:
+    using value_type = std::pair<std::pmr::string, Node>;
+    using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+    using iterator = std::pmr::vector<value_type>::iterator;
+    using const_iterator = std::pmr::vector<value_type>::const_iterator;
+
+    Dict() = default;
+    explicit Dict(const allocator_type& allocator)
+        : entries_(allocator) {
+    }
+
+    const Node& at(std::string_view key) const;
+    size_t count(std::string_view key) const;
+    const_iterator find(std::string_view key) const;
+    iterator find(std::string_view key);
+    std::pair<iterator, bool> emplace(std::string_view key, Node value);
+
+    const_iterator begin() const {
+        return entries_.begin();
+    }
+    const_iterator end() const {
+        return entries_.end();
+    }
+    iterator begin() {
+        return entries_.begin();
+    }
+    iterator end() {
+        return entries_.end();
+    }
+    size_t size() const {
+        return entries_.size();
+    }
+    bool empty() const {
+        return entries_.empty();
+    }
+
+private:
+    const_iterator LowerBound(std::string_view key) const;
+
+    std::pmr::vector<value_type> entries_;
+};
 
 class ParsingError : public std::runtime_error {
 public:
     using runtime_error::runtime_error;
 };
 
+// Строка, прочитанная из буфера, хранится как string_view на буфер или арену документа,
+// поэтому такие узлы действительны, пока жив сам документ.
 class Node final
-    : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+    : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string, std::string_view> {
 public:
     using variant::variant;
     using Value = variant;
@@ -77,14 +132,17 @@ public:
     }
 
     bool IsString() const {
-        return std::holds_alternative<std::string>(*this);
+        return std::holds_alternative<std::string>(*this) || std::holds_alternative<std::string_view>(*this);
     }
-    const std::string& AsString() const {
+    std::string_view AsString() const {
         using namespace std::literals;
         if (!IsString()) {
             throw std::logic_error("Not a string"s);
         }
 
+        if (const auto* view = std::get_if<std::string_view>(this)) {
+            return *view;
+        }
         return std::get<std::string>(*this);
     }
 
@@ -101,6 +159,9 @@ public:
     }
 
     bool operator==(const Node& rhs) const {
+        if (IsString() && rhs.IsString()) {
+            return AsString() == rhs.AsString();
+        }
         return GetValue() == rhs.GetValue();
     }
 
@@ -117,17 +178,80 @@ inline bool operator!=(const Node& lhs, const Node& rhs) {
     return !(lhs == rhs);
 }
 
+inline Dict::const_iterator Dict::LowerBound(std::string_view key) const {
+    return std::lower_bound(entries_.begin(), entries_.end(), key, [](const value_type& entry, std::string_view key) {
+        return std::string_view(entry.first) < key;
+    });
+}
+
+inline Dict::const_iterator Dict::find(std::string_view key) const {
+    const auto it = LowerBound(key);
+    return it != entries_.end() && it->first == key ? it : entries_.end();
+}
+
+inline Dict::iterator Dict::find(std::string_view key) {
+    return entries_.begin() + (static_cast<const Dict&>(*this).find(key) - entries_.cbegin());
+}
+
+inline const Node& Dict::at(std::string_view key) const {
+    using namespace std::literals;
+    const auto it = find(key);
+    if (it == entries_.end()) {
+        throw std::out_of_range("Key '"s + std::string(key) + "' is not found"s);
+    }
+    return it->second;
+}
+
+inline size_t Dict::count(std::string_view key) const {
+    return find(key) != entries_.end() ? 1 : 0;
+}
+
+inline std::pair<Dict::iterator, bool> Dict::emplace(std::string_view key, Node value) {
+    const auto position = entries_.begin() + (LowerBound(key) - entries_.cbegin());
+    if (position != entries_.end() && position->first == key) {
+        return { position, false };
+    }
+    return { entries_.emplace(position, std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::move(value))), true };
+}
+
+inline bool operator==(const Dict& lhs, const Dict& rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+inline bool operator!=(const Dict& lhs, const Dict& rhs) {
+    return !(lhs == rhs);
+}
+
 class Document {
 public:
     explicit Document(Node root)
         : root_(std::move(root)) {
     }
 
+    // Исходный буфер и арена, из которой выделены контейнеры разобранного документа.
+    // Узлы не освобождаются по одному: память арены возвращается целиком вместе с хранилищем
+    struct Storage {
+        explicit Storage(std::string source)
+            : buffer(std::move(source))
+            , arena(std::max<size_t>(buffer.size(), 1024)) {
+        }
+
+        const std::string buffer;
+        std::pmr::monotonic_buffer_resource arena;
+    };
+
+    Document(Node root, std::shared_ptr<Storage> storage)
+        : storage_(std::move(storage))
+        , root_(std::move(root)) {
+    }
+
     const Node& GetRoot() const {
         return root_;
     }
 
 private:
+    // Объявлено до root_, чтобы узлы разрушались раньше арены
+    std::shared_ptr<Storage> storage_;
     Node root_;
 };
 
@@ -140,7 +264,12 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
 }
 
 Document Load(std::istream& input);
+// Разбирает непрерывный буфер целиком: строки без экранирования становятся string_view на буфер,
+// контейнеры и остальные строки выделяются из арены. Буфером и ареной затем владеет документ
+Document LoadBuffer(std::string buffer);
+Document LoadBuffer(std::istream& input);
 
+// Выводит документ с отступами, double — с шестью значащими цифрами, как std::ostream по умолчанию
 void Print(const Document& doc, std::ostream& output);
 
 } // namespace json
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "json_index.h"
+#include "json_scan.h"
+
+namespace json {
+
+namespace {
+
+using namespace std::literals;
+
+class Indexer {
+public:
+    explicit Indexer(std::string_view text)
+        : pos_(text.data())
+        , end_(text.data() + text.size())
+    {
+    }
+
+    std::vector<IndexedMember> IndexObject() {
+        std::vector<IndexedMember> members;
+        Expect('{');
+        if (TryConsume('}')) {
+            ExpectEnd();
+            return members;
+        }
+        do {
+            Expect('"');
+            const char* key_begin = pos_;
+            SkipString();
+            const std::string_view key(key_begin, pos_ - key_begin - 1);
+            Expect(':');
+            members.push_back({ key, SkipValue() });
+        } while (TryConsume(','));
+        Expect('}');
+        ExpectEnd();
+        return members;
+    }
+
+    std::vector<std::string_view> IndexArray() {
+        std::vector<std::string_view> elements;
+        Expect('[');
+        if (TryConsume(']')) {
+            ExpectEnd();
+            return elements;
+        }
+        do {
+            elements.push_back(SkipValue());
+        } while (TryConsume(','));
+        Expect(']');
+        ExpectEnd();
+        return elements;
+    }
+
+private:
+    const char* pos_;
+    const char* end_;
+
+    static bool IsSpace(char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+    }
+
+    void SkipSpaces() {
+        while (pos_ != end_ && IsSpace(*pos_)) {
+            ++pos_;
+        }
+    }
+
+    bool TryConsume(char c) {
+        SkipSpaces();
+        if (pos_ != end_ && *pos_ == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(char c) {
+        if (!TryConsume(c)) {
+            throw ParsingError("'"s + c + "' is expected"s);
+        }
+    }
+
+    void ExpectEnd() {
+        SkipSpaces();
+        if (pos_ != end_) {
+            throw ParsingError("Unexpected data after JSON value"s);
+        }
+    }
+
+    // Позиция сразу за открывающей кавычкой, сдвигается за закрывающую
+    void SkipString() {
+        while (true) {
+            pos_ = FindStringSpecial(pos_, end_);
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error"s);
+            }
+            const char c = *pos_++;
+            if (c == '"') {
+                return;
+            }
+            if (c != '\\') {
+                throw ParsingError("Unexpected end of line"s);
+            }
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error"s);
+            }
+            ++pos_;
+        }
+    }
+
+    // Пропускает значение целиком и возвращает его текст
+    std::string_view SkipValue() {
+        SkipSpaces();
+        const char* begin = pos_;
+        size_t depth = 0;
+        while (pos_ != end_) {
+            const char c = *pos_;
+            if (c == '"') {
+                ++pos_;
+                SkipString();
+            }
+            else if (c == '[' || c == '{') {
+                ++depth;
+                ++pos_;
+            }
+            else if (c == ']' || c == '}') {
+                if (depth == 0) {
+                    break;
+                }
+                --depth;
+                ++pos_;
+            }
+            else if (c == ',' && depth == 0) {
+                break;
+            }
+            else {
+                ++pos_;
+            }
+            if (depth == 0 && (c == '"' || c == ']' || c == '}')) {
+                break;
+            }
+        }
+        if (depth != 0) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        const char* end = pos_;
+        while (end != begin && IsSpace(end[-1])) {
+            --end;
+        }
+        if (end == begin) {
+            throw ParsingError("A value is expected"s);
+        }
+        return { begin, static_cast<size_t>(end - begin) };
+    }
+};
+
+} // namespace
+
+std::vector<IndexedMember> IndexObject(std::string_view text) {
+    return Indexer(text).IndexObject();
+}
+
+std::vector<std::string_view> IndexArray(std::string_view text) {
+    return Indexer(text).IndexArray();
+}
+
+} // namespace json
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "json.h"
+
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+/*
+    * Структурный проход по тексту: находит границы значений верхнего уровня, не разбирая их
+    * и не строя узлов. Внутренность строк пропускается блоками через FindStringSpecial,
+    * поэтому проход заметно быстрее полного разбора и позволяет затем разбирать части параллельно.
+    * Проверяются только скобки и строки, синтаксис самих значений проверит последующий разбор
+    */
+
+struct IndexedMember {
+    // Ключ без кавычек, экранирование не раскрывается
+    std::string_view key;
+    std::string_view value;
+};
+
+// Члены объекта, которым является text (с точностью до пробелов по краям)
+std::vector<IndexedMember> IndexObject(std::string_view text);
+
+// Элементы массива, которым является text (с точностью до пробелов по краям)
+std::vector<std::string_view> IndexArray(std::string_view text);
+
+} // namespace json
@@ -1,11 +1,640 @@
 #include "json_reader.h"
 #include "json_builder.h"
+#include "json_index.h"
+#include "json_sax.h"
+#include "json_writer.h"
+
+#include <algorithm>
+#include <array>
+#include <future>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
 
 using namespace std::literals;
 
-const json::Node& JsonReader::GetBaseRequests() const {
-    if (!input_.GetRoot().AsDict().count("base_requests"s)) return dummy_;
-    return input_.GetRoot().AsDict().at("base_requests"s);
+namespace {
+
+/*
+    * Обработчик событий для make_base: элементы base_requests сразу передаются в Sink
+    * (CatalogueBuilder или RecordedRequests), а в памяти держится только текущий запрос.
+    * Остальные разделы верхнего уровня невелики и собираются в узлы как обычно
+    */
+template <typename Sink>
+class BaseRequestsHandler final : public json::SaxHandler {
+public:
+    explicit BaseRequestsHandler(Sink& builder)
+        : builder_(builder)
+    {
+    }
+
+    json::Dict ExtractSections() {
+        return std::move(sections_);
+    }
+
+    void Null() override {
+        if (in_section_) {
+            section_.Null();
+            OnSectionEvent();
+        }
+    }
+
+    void Bool(bool value) override {
+        if (in_section_) {
+            section_.Bool(value);
+            OnSectionEvent();
+        }
+        else if (depth_ == REQUEST_DEPTH && key_ == "is_roundtrip"sv) {
+            request_.is_roundtrip = value;
+        }
+    }
+
+    void Int(int value) override {
+        if (in_section_) {
+            section_.Int(value);
+            OnSectionEvent();
+        }
+        else if (depth_ == REQUEST_DEPTH + 1 && in_distances_) {
+            request_.road_distances.emplace_back(distance_to_, value);
+        }
+        else {
+            SetCoordinate(value);
+        }
+    }
+
+    void Double(double value) override {
+        if (in_section_) {
+            section_.Double(value);
+            OnSectionEvent();
+        }
+        else if (depth_ == REQUEST_DEPTH + 1 && in_distances_) {
+            // Расстояние по дорогам задаётся целым числом метров, дробное считается ошибкой входных данных
+            throw std::invalid_argument("Road distance to '"s + distance_to_ + "' is not an int"s);
+        }
+        else {
+            SetCoordinate(value);
+        }
+    }
+
+    void String(std::string_view value) override {
+        if (in_section_) {
+            section_.String(value);
+            OnSectionEvent();
+        }
+        else if (depth_ == REQUEST_DEPTH && key_ == "type"sv) {
+            request_.type = value;
+        }
+        else if (depth_ == REQUEST_DEPTH && key_ == "name"sv) {
+            request_.name = value;
+        }
+        else if (depth_ == REQUEST_DEPTH + 1 && in_stops_) {
+            request_.stops.emplace_back(value);
+        }
+    }
+
+    void StartArray() override {
+        if (in_section_) {
+            section_.StartArray();
+            return;
+        }
+        ++depth_;
+        in_stops_ = depth_ == REQUEST_DEPTH + 1 && key_ == "stops"sv;
+    }
+
+    void EndArray() override {
+        if (in_section_) {
+            section_.EndArray();
+            OnSectionEvent();
+            return;
+        }
+        --depth_;
+        in_stops_ = false;
+    }
+
+    void StartDict() override {
+        if (in_section_) {
+            section_.StartDict();
+            return;
+        }
+        ++depth_;
+        if (depth_ == REQUEST_DEPTH) {
+            request_.Clear();
+        }
+        in_distances_ = depth_ == REQUEST_DEPTH + 1 && key_ == "road_distances"sv;
+    }
+
+    void Key(std::string_view key) override {
+        if (in_section_) {
+            section_.Key(key);
+        }
+        else if (depth_ == 1 && key != "base_requests"sv) {
+            in_section_ = true;
+            section_key_ = key;
+        }
+        else if (depth_ == REQUEST_DEPTH) {
+            key_ = key;
+        }
+        else if (depth_ == REQUEST_DEPTH + 1 && in_distances_) {
+            distance_to_ = key;
+        }
+    }
+
+    void EndDict() override {
+        if (in_section_) {
+            section_.EndDict();
+            OnSectionEvent();
+            return;
+        }
+        if (depth_ == REQUEST_DEPTH) {
+            AddRequest();
+        }
+        --depth_;
+        in_distances_ = false;
+    }
+
+private:
+    // Глубина словаря запроса: корневой словарь, массив base_requests, запрос
+    static constexpr size_t REQUEST_DEPTH = 3;
+
+    struct BaseRequest {
+        std::string type;
+        std::string name;
+        double latitude = 0.0;
+        double longitude = 0.0;
+        bool is_roundtrip = false;
+        std::vector<std::pair<std::string, int>> road_distances;
+        std::vector<std::string> stops;
+
+        void Clear() {
+            type.clear();
+            name.clear();
+            latitude = 0.0;
+            longitude = 0.0;
+            is_roundtrip = false;
+            road_distances.clear();
+            stops.clear();
+        }
+    };
+
+    Sink& builder_;
+    json::Dict sections_;
+    json::NodeBuilder section_;
+    std::string section_key_;
+    bool in_section_ = false;
+
+    size_t depth_ = 0;
+    std::string key_;
+    std::string distance_to_;
+    bool in_distances_ = false;
+    bool in_stops_ = false;
+    BaseRequest request_;
+    std::vector<std::string_view> stop_names_;
+
+    void OnSectionEvent() {
+        if (section_.IsComplete()) {
+            sections_.emplace(section_key_, section_.Extract());
+            in_section_ = false;
+        }
+    }
+
+    void SetCoordinate(double value) {
+        if (depth_ != REQUEST_DEPTH) {
+            return;
+        }
+        if (key_ == "latitude"sv) {
+            request_.latitude = value;
+        }
+        else if (key_ == "longitude"sv) {
+            request_.longitude = value;
+        }
+    }
+
+    void AddRequest() {
+        if (request_.type == "Stop"sv) {
+            builder_.AddStop(request_.name, { request_.latitude, request_.longitude });
+            for (const auto& [to_name, distance] : request_.road_distances) {
+                builder_.AddDistance(request_.name, to_name, distance);
+            }
+        }
+        else if (request_.type == "Bus"sv) {
+            stop_names_.assign(request_.stops.begin(), request_.stops.end());
+            builder_.AddBus(request_.name, stop_names_, request_.is_roundtrip);
+        }
+    }
+};
+
+/*
+    * Запоминает вызовы CatalogueBuilder в порядке поступления, чтобы воспроизвести их позже.
+    * Так части base_requests разбираются в разных потоках, а каталог получает ровно ту же
+    * последовательность вызовов, что и при последовательном разборе
+    */
+class RecordedRequests {
+public:
+    RecordedRequests& AddStop(std::string_view name, geo::Coordinates coordinates) {
+        calls_.push_back({ CallType::STOP, names_.size(), 1, coordinates, 0, false });
+        AddName(name);
+        return *this;
+    }
+
+    RecordedRequests& AddDistance(std::string_view from, std::string_view to, int distance) {
+        calls_.push_back({ CallType::DISTANCE, names_.size(), 2, { 0.0, 0.0 }, distance, false });
+        AddName(from);
+        AddName(to);
+        return *this;
+    }
+
+    RecordedRequests& AddBus(std::string_view number, const std::vector<std::string_view>& stops, bool is_circle) {
+        calls_.push_back({ CallType::BUS, names_.size(), stops.size() + 1, { 0.0, 0.0 }, 0, is_circle });
+        AddName(number);
+        for (const std::string_view stop : stops) {
+            AddName(stop);
+        }
+        return *this;
+    }
+
+    void Replay(transport::CatalogueBuilder& builder) const {
+        std::vector<std::string_view> stops;
+        for (const Call& call : calls_) {
+            switch (call.type) {
+            case CallType::STOP:
+                builder.AddStop(GetName(call.first_name), call.coordinates);
+                break;
+            case CallType::DISTANCE:
+                builder.AddDistance(GetName(call.first_name), GetName(call.first_name + 1), call.distance);
+                break;
+            case CallType::BUS:
+                stops.clear();
+                for (size_t i = 1; i < call.name_count; ++i) {
+                    stops.push_back(GetName(call.first_name + i));
+                }
+                builder.AddBus(GetName(call.first_name), stops, call.is_circle);
+                break;
+            }
+        }
+    }
+
+private:
+    enum class CallType {
+        STOP,
+        DISTANCE,
+        BUS
+    };
+
+    struct Call {
+        CallType type;
+        size_t first_name;
+        size_t name_count;
+        geo::Coordinates coordinates;
+        int distance;
+        bool is_circle;
+    };
+
+    std::vector<Call> calls_;
+    // Имена хранятся подряд в chars_, names_ — их начала и длины
+    std::string chars_;
+    std::vector<std::pair<size_t, size_t>> names_;
+
+    void AddName(std::string_view name) {
+        names_.emplace_back(chars_.size(), name.size());
+        chars_ += name;
+    }
+
+    std::string_view GetName(size_t index) const {
+        return std::string_view(chars_).substr(names_[index].first, names_[index].second);
+    }
+};
+
+// Меньшие части не окупают запуск потока
+constexpr size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+// Разбирает подряд идущие элементы base_requests, обернув их в документ того же вида, что и весь вход
+RecordedRequests ParseBaseChunk(std::string_view first, std::string_view last) {
+    std::string text = "{\"base_requests\":["s;
+    text.append(first.data(), last.data() + last.size());
+    text += "]}"sv;
+
+    RecordedRequests requests;
+    BaseRequestsHandler<RecordedRequests> handler(requests);
+    std::istringstream input(std::move(text));
+    json::ParseSax(input, handler);
+    return requests;
+}
+
+using transport::RequestField;
+
+constexpr uint32_t FieldBit(RequestField field) {
+    return 1u << static_cast<uint32_t>(field);
+}
+
+// Отсутствие обязательного поля — ошибка, как и прежде при обращении через at
+void RequireFields(uint32_t seen, uint32_t required) {
+    if ((seen & required) != required) {
+        throw std::invalid_argument("Request misses a required field"s);
+    }
+}
+
+// Один проход по полям запроса: имя поля разбирается по таблице, значение получает handler.
+// Возвращает маску встреченных полей
+template <typename Handler>
+uint32_t ForEachField(const json::Dict& request_map, uint32_t required, Handler handler) {
+    uint32_t seen = 0;
+    for (const auto& [key, value] : request_map) {
+        const RequestField field = transport::ParseRequestField(key);
+        seen |= FieldBit(field);
+        handler(field, value);
+    }
+    RequireFields(seen, required);
+    return seen;
+}
+
+geo::Coordinates BindCoordinates(const json::Dict& coordinates_map) {
+    geo::Coordinates coordinates = { 0.0, 0.0 };
+    ForEachField(coordinates_map, FieldBit(RequestField::LATITUDE) | FieldBit(RequestField::LONGITUDE),
+        [&coordinates](RequestField field, const json::Node& value) {
+            if (field == RequestField::LATITUDE) {
+                coordinates.lat = value.AsDouble();
+            }
+            else if (field == RequestField::LONGITUDE) {
+                coordinates.lng = value.AsDouble();
+            }
+        });
+    return coordinates;
+}
+
+template <typename Request>
+transport::StatRequest BindNamed(const json::Dict& request_map) {
+    Request request;
+    ForEachField(request_map, FieldBit(RequestField::ID) | FieldBit(RequestField::NAME),
+        [&request](RequestField field, const json::Node& value) {
+            if (field == RequestField::ID) {
+                request.id = value.AsInt();
+            }
+            else if (field == RequestField::NAME) {
+                request.name = value.AsString();
+            }
+        });
+    return request;
+}
+
+transport::StatRequest BindMap(const json::Dict& request_map) {
+    transport::MapRequest request;
+    ForEachField(request_map, FieldBit(RequestField::ID), [&request](RequestField field, const json::Node& value) {
+        switch (field) {
+        case RequestField::ID:
+            request.id = value.AsInt();
+            break;
+        case RequestField::VIEWPORT: {
+            // Два противоположных угла окна
+            const json::Array& corners = value.AsArray();
+            if (corners.size() != 2) {
+                throw std::invalid_argument("Viewport must have two corners"s);
+            }
+            request.viewport = geo::MakeBoundingBox(BindCoordinates(corners[0].AsDict()), BindCoordinates(corners[1].AsDict()));
+            break;
+        }
+        case RequestField::ZOOM:
+            request.zoom = value.AsInt();
+            break;
+        default:
+            break;
+        }
+    });
+    return request;
+}
+
+// Маршрут между остановками и маршрут между точками различаются только набором полей
+transport::StatRequest BindRoute(const json::Dict& request_map) {
+    transport::RouteRequest by_stops;
+    transport::CoordinatesRouteRequest by_coordinates;
+    bool has_coordinates = false;
+    const uint32_t seen = ForEachField(request_map, FieldBit(RequestField::ID), [&](RequestField field, const json::Node& value) {
+        switch (field) {
+        case RequestField::ID:
+            by_stops.id = by_coordinates.id = value.AsInt();
+            break;
+        case RequestField::FROM:
+            by_stops.from = value.AsString();
+            break;
+        case RequestField::TO:
+            by_stops.to = value.AsString();
+            break;
+        case RequestField::FROM_COORDINATES:
+            by_coordinates.from = BindCoordinates(value.AsDict());
+            has_coordinates = true;
+            break;
+        case RequestField::TO_COORDINATES:
+            by_coordinates.to = BindCoordinates(value.AsDict());
+            break;
+        case RequestField::WALKING_SPEED:
+            by_coordinates.walking_speed = value.AsDouble();
+            break;
+        default:
+            break;
+        }
+    });
+    if (has_coordinates) {
+        RequireFields(seen, FieldBit(RequestField::TO_COORDINATES) | FieldBit(RequestField::WALKING_SPEED));
+        // Нулевая скорость дала бы бесконечные веса пеших рёбер, отрицательная — отрицательные
+        if (!(by_coordinates.walking_speed > 0.0)) {
+            throw std::invalid_argument("walking_speed must be positive"s);
+        }
+        return by_coordinates;
+    }
+    RequireFields(seen, FieldBit(RequestField::FROM) | FieldBit(RequestField::TO));
+    return by_stops;
+}
+
+transport::StatRequest BindCommonBuses(const json::Dict& request_map) {
+    transport::CommonBusesRequest request;
+    ForEachField(request_map, FieldBit(RequestField::ID) | FieldBit(RequestField::STOPS),
+        [&request](RequestField field, const json::Node& value) {
+            if (field == RequestField::ID) {
+                request.id = value.AsInt();
+            }
+            else if (field == RequestField::STOPS) {
+                const auto& stops = value.AsArray();
+                request.stops.reserve(stops.size());
+                for (const auto& stop : stops) {
+                    request.stops.push_back(stop.AsString());
+                }
+            }
+        });
+    return request;
+}
+
+transport::StatRequest BindRouteSegment(const json::Dict& request_map) {
+    transport::RouteSegmentRequest request;
+    ForEachField(request_map,
+        FieldBit(RequestField::ID) | FieldBit(RequestField::BUS) | FieldBit(RequestField::FROM) | FieldBit(RequestField::TO),
+        [&request](RequestField field, const json::Node& value) {
+            switch (field) {
+            case RequestField::ID:
+                request.id = value.AsInt();
+                break;
+            case RequestField::BUS:
+                request.bus = value.AsString();
+                break;
+            case RequestField::FROM:
+                request.from = value.AsString();
+                break;
+            case RequestField::TO:
+                request.to = value.AsString();
+                break;
+            default:
+                break;
+            }
+        });
+    return request;
+}
+
+transport::StatRequest BindNearestStops(const json::Dict& request_map) {
+    transport::NearestStopsRequest request;
+    ForEachField(request_map,
+        FieldBit(RequestField::ID) | FieldBit(RequestField::LATITUDE) | FieldBit(RequestField::LONGITUDE)
+            | FieldBit(RequestField::RADIUS) | FieldBit(RequestField::LIMIT),
+        [&request](RequestField field, const json::Node& value) {
+            switch (field) {
+            case RequestField::ID:
+                request.id = value.AsInt();
+                break;
+            case RequestField::LATITUDE:
+                request.center.lat = value.AsDouble();
+                break;
+            case RequestField::LONGITUDE:
+                request.center.lng = value.AsDouble();
+                break;
+            case RequestField::RADIUS:
+                request.radius = value.AsDouble();
+                break;
+            case RequestField::LIMIT:
+                request.limit = value.AsInt();
+                break;
+            default:
+                break;
+            }
+        });
+    return request;
+}
+
+transport::StatRequest BindStopSearch(const json::Dict& request_map) {
+    transport::StopSearchRequest request;
+    ForEachField(request_map, FieldBit(RequestField::ID) | FieldBit(RequestField::PREFIX),
+        [&request](RequestField field, const json::Node& value) {
+            switch (field) {
+            case RequestField::ID:
+                request.id = value.AsInt();
+                break;
+            case RequestField::PREFIX:
+                request.prefix = value.AsString();
+                break;
+            case RequestField::MAX_EDITS:
+                request.max_edits = value.AsInt();
+                break;
+            case RequestField::LIMIT:
+                request.limit = value.AsInt();
+                break;
+            default:
+                break;
+            }
+        });
+    return request;
+}
+
+std::optional<int> FindRequestId(const json::Dict& request_map) {
+    if (const auto it = request_map.find("id"sv); it != request_map.end() && it->second.IsInt()) {
+        return it->second.AsInt();
+    }
+    return std::nullopt;
+}
+
+transport::StatRequest BindUnknown(const json::Dict& request_map) {
+    return transport::UnknownRequest{ FindRequestId(request_map) };
+}
+
+using RequestBinder = transport::StatRequest (*)(const json::Dict&);
+
+// Индекс — RequestType, последний элемент обрабатывает неизвестные типы
+constexpr std::array<RequestBinder, static_cast<size_t>(transport::RequestType::UNKNOWN) + 1> REQUEST_BINDERS = {
+    BindNamed<transport::StopRequest>,
+    BindNamed<transport::BusRequest>,
+    BindMap,
+    BindRoute,
+    BindCommonBuses,
+    BindRouteSegment,
+    BindNearestStops,
+    BindStopSearch,
+    BindUnknown
+};
+
+transport::StatRequest BindStatRequest(const json::Dict& request_map) {
+    const transport::RequestType type = transport::ParseRequestType(request_map.at("type"sv).AsString());
+    return REQUEST_BINDERS[static_cast<size_t>(type)](request_map);
+}
+
+// Ответ на запрос, отклонённый при разборе; id неизвестен, если его не удалось прочитать
+void WriteError(std::optional<int> id, std::string_view message, json::Writer& writer) {
+    writer.StartDict()
+        .Key("error_message"sv).Value(message)
+        .Key("request_id"sv).Value(id ? json::Node(*id) : json::Node{})
+    .EndDict();
+}
+
+void WriteNotFound(int id, json::Writer& writer) {
+    writer.StartDict()
+        .Key("error_message"sv).Value("not found"sv)
+        .Key("request_id"sv).Value(id)
+    .EndDict();
+}
+
+} // namespace
+
+std::pair<JsonReader, transport::TransportCatalogue> JsonReader::ReadBase(std::istream& input, size_t jobs) {
+    transport::CatalogueBuilder builder;
+    if (jobs <= 1) {
+        BaseRequestsHandler<transport::CatalogueBuilder> handler(builder);
+        json::ParseSax(input, handler);
+        return { JsonReader(json::Document{ handler.ExtractSections() }), builder.Build() };
+    }
+
+    const std::string text(std::istreambuf_iterator<char>(input), {});
+    std::string_view base_requests;
+    // Остальные разделы собираются в отдельный небольшой документ и разбираются как обычно
+    std::string sections = "{"s;
+    for (const auto& [key, value] : json::IndexObject(text)) {
+        if (key == "base_requests"sv) {
+            base_requests = value;
+            continue;
+        }
+        if (sections.size() > 1) {
+            sections += ',';
+        }
+        sections.append("\""sv).append(key).append("\":"sv).append(value);
+    }
+    sections += '}';
+    JsonReader reader(json::LoadBuffer(std::move(sections)));
+
+    const std::vector<std::string_view> elements = base_requests.empty()
+        ? std::vector<std::string_view>{}
+        : json::IndexArray(base_requests);
+    const size_t chunk_count = std::clamp<size_t>(base_requests.size() / MIN_CHUNK_SIZE, 1, jobs);
+
+    // Части разбираются параллельно, а в builder попадают строго по порядку
+    std::vector<std::future<RecordedRequests>> chunks;
+    for (size_t chunk = 0; chunk < chunk_count && !elements.empty(); ++chunk) {
+        const size_t from = elements.size() * chunk / chunk_count;
+        const size_t to = elements.size() * (chunk + 1) / chunk_count;
+        if (from == to) {
+            continue;
+        }
+        chunks.push_back(std::async(chunk == 0 ? std::launch::deferred : std::launch::async,
+            ParseBaseChunk, elements[from], elements[to - 1]));
+    }
+    for (auto& chunk : chunks) {
+        chunk.get().Replay(builder);
+    }
+    return { std::move(reader), builder.Build() };
 }
 
 const json::Node& JsonReader::GetStatRequests() const {
@@ -28,82 +657,79 @@ const json::Node& JsonReader::GetSerializationSettings() const {
     return input_.GetRoot().AsDict().at("serialization_settings"s);
 }
 
-void JsonReader::ProcessRequests(const json::Node& stat_requests, RequestHandler& rh) const {
-    json::Array result;
+void JsonReader::ProcessRequests(const json::Node& stat_requests, RequestHandler& rh, const json::WriterOptions& output_options) const {
+    // Каждый ответ записывается сразу после вычисления, общий массив ответов не собирается
+    json::Writer writer(std::cout, output_options);
+    writer.StartArray();
     for (auto& request : stat_requests.AsArray()) {
-        const auto& request_map = request.AsDict();
-        const auto& type = request_map.at("type"s).AsString();
-        if (type == "Stop"s) 
-            result.push_back(PrintStop(request_map, rh).AsDict());
-        if (type == "Bus"s) 
-            result.push_back(PrintRoute(request_map, rh).AsDict());
-        if (type == "Map"s) 
-            result.push_back(PrintMap(request_map, rh).AsDict());
-        if (type == "Route"s) 
-            result.push_back(PrintRouting(request_map, rh).AsDict());
-    }
-
-    json::Print(json::Document{ result }, std::cout);
-}
-
-void JsonReader::FillCatalogue(transport::TransportCatalogue& catalogue) {
-    const json::Array& arr = GetBaseRequests().AsArray();
-    for (auto& request_stops : arr) {
-        const auto& request_stops_map = request_stops.AsDict();
-        const auto& type = request_stops_map.at("type"s).AsString();
-        if (type == "Stop"s) {
-            auto [stop_name, coordinates, stop_distances] = FillStop(request_stops_map);
-            catalogue.AddStop(stop_name, coordinates);
+        // Разбор запроса заканчивается до записи ответа, поэтому отклонённый запрос получает ответ с ошибкой
+        transport::StatRequest bound;
+        try {
+            bound = BindStatRequest(request.AsDict());
         }
-    }
-    FillStopDistances(catalogue);
-
-    for (auto& request_bus : arr) {
-        const auto& request_bus_map = request_bus.AsDict();
-        const auto& type = request_bus_map.at("type"s).AsString();
-        if (type == "Bus"s) {
-            auto [bus_number, stops, circular_route] = FillRoute(request_bus_map, catalogue);
-            catalogue.AddRoute(bus_number, stops, circular_route);
+        catch (const std::invalid_argument& e) {
+            WriteError(FindRequestId(request.AsDict()), e.what(), writer);
+            continue;
         }
+        WriteResponse(bound, rh, writer);
     }
+    writer.EndArray();
 }
 
-std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> JsonReader::FillStop(const json::Dict& request_map) const {
-    std::string_view stop_name = request_map.at("name"s).AsString();
-    geo::Coordinates coordinates = { request_map.at("latitude"s).AsDouble(), request_map.at("longitude"s).AsDouble() };
-    std::map<std::string_view, int> stop_distances;
-    auto& distances = request_map.at("road_distances"s).AsDict();
-    for (auto& [stop_name, dist] : distances) {
-        stop_distances.emplace(stop_name, dist.AsInt());
-    }
-    return std::make_tuple(stop_name, coordinates, stop_distances);
-}
-
-void JsonReader::FillStopDistances(transport::TransportCatalogue& catalogue) const {
-    const json::Array& arr = GetBaseRequests().AsArray();
-    for (auto& request_stops : arr) {
-        const auto& request_stops_map = request_stops.AsDict();
-        const auto& type = request_stops_map.at("type"s).AsString();
-        if (type == "Stop"s) {
-            auto [stop_name, coordinates, stop_distances] = FillStop(request_stops_map);
-            for (auto& [to_name, dist] : stop_distances) {
-                auto from = catalogue.FindStop(stop_name);
-                auto to = catalogue.FindStop(to_name);
-                catalogue.SetDistance(from, to, dist);
+void JsonReader::ProcessRequestStream(std::istream& input, const transport::SnapshotHolder& snapshots, const json::WriterOptions& output_options) const {
+    json::WriterOptions line_options = output_options;
+    line_options.compact = true;
+    json::Writer writer(std::cout, line_options);
+
+    // Ответ сначала пишется в отдельный буфер: если запрос упадёт посреди ответа,
+    // в общий вывод не попадёт недописанный объект, а writer останется на верхнем уровне
+    std::ostringstream response;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r"sv) == std::string::npos) {
+            continue;
+        }
+        // Ошибка в одной строке не должна останавливать весь поток, на неё отвечает строка с error_message
+        std::optional<int> id;
+        response.str({});
+        try {
+            const json::Document document = json::LoadBuffer(std::move(line));
+            if (document.GetRoot().IsDict()) {
+                id = FindRequestId(document.GetRoot().AsDict());
+            }
+            const transport::StatRequest request = BindStatRequest(document.GetRoot().AsDict());
+            RequestHandler rh(snapshots.Get());
+            json::Writer response_writer(response, line_options);
+            if (!WriteResponse(request, rh, response_writer)) {
+                WriteError(id, "unknown request"sv, response_writer);
             }
+            response_writer.Flush();
+            writer.RawValue(response.str());
+        }
+        catch (const std::exception& e) {
+            WriteError(id, e.what(), writer);
+        }
+        writer.EndLine();
+        line.clear();
+
+        // Пачка строк, уже лежащих во входном буфере, отвечается одним сбросом
+        if (input.rdbuf()->in_avail() <= 0) {
+            writer.Flush();
+            std::cout.flush();
         }
     }
 }
 
-std::tuple<std::string_view, std::vector<const transport::Stop*>, bool> JsonReader::FillRoute(const json::Dict& request_map, transport::TransportCatalogue& catalogue) const {
-    std::string_view bus_number = request_map.at("name"s).AsString();
-    std::vector<const transport::Stop*> stops;
-    for (auto& stop : request_map.at("stops"s).AsArray()) {
-        stops.push_back(catalogue.FindStop(stop.AsString()));
+bool JsonReader::WriteResponse(const transport::StatRequest& request, RequestHandler& rh, json::Writer& writer) const {
+    if (std::holds_alternative<transport::UnknownRequest>(request)) {
+        return false;
     }
-    bool circular_route = request_map.at("is_roundtrip"s).AsBool();
-
-    return std::make_tuple(bus_number, stops, circular_route);
+    std::visit([this, &rh, &writer](const auto& typed_request) {
+        if constexpr (!std::is_same_v<std::decay_t<decltype(typed_request)>, transport::UnknownRequest>) {
+            Print(typed_request, rh, writer);
+        }
+    }, request);
+    return true;
 }
 
 renderer::MapRenderer JsonReader::FillRenderSettings(const json::Node& settings) const {
@@ -121,7 +747,7 @@ renderer::MapRenderer JsonReader::FillRenderSettings(const json::Node& settings)
     const json::Array& stop_label_offset = request_map.at("stop_label_offset"s).AsArray();
     render_settings.stop_label_offset = { stop_label_offset[0].AsDouble(), stop_label_offset[1].AsDouble() };
 
-    if (request_map.at("underlayer_color"s).IsString()) render_settings.underlayer_color = request_map.at("underlayer_color"s).AsString();
+    if (request_map.at("underlayer_color"s).IsString()) render_settings.underlayer_color = std::string(request_map.at("underlayer_color"s).AsString());
     else if (request_map.at("underlayer_color"s).IsArray()) {
         const json::Array& underlayer_color = request_map.at("underlayer_color"s).AsArray();
         if (underlayer_color.size() == 3) {
@@ -138,7 +764,7 @@ renderer::MapRenderer JsonReader::FillRenderSettings(const json::Node& settings)
 
     const json::Array& color_palette = request_map.at("color_palette"s).AsArray();
     for (const auto& color_element : color_palette) {
-        if (color_element.IsString()) render_settings.color_palette.push_back(color_element.AsString());
+        if (color_element.IsString()) render_settings.color_palette.push_back(std::string(color_element.AsString()));
         else if (color_element.IsArray()) {
             const json::Array& color_type = color_element.AsArray();
             if (color_type.size() == 3) {
@@ -152,6 +778,17 @@ renderer::MapRenderer JsonReader::FillRenderSettings(const json::Node& settings)
         else throw std::logic_error("wrong color_palette"s);
     }
 
+    if (const auto it = request_map.find("coordinate_precision"sv); it != request_map.end()) {
+        const int precision = it->second.AsInt();
+        if (precision < 1 || precision > 17) throw std::logic_error("wrong coordinate_precision"s);
+        render_settings.coordinate_precision = precision;
+    }
+
+    if (const auto it = request_map.find("simplify_tolerance"sv); it != request_map.end()) {
+        render_settings.simplify_tolerance = it->second.AsDouble();
+        if (render_settings.simplify_tolerance < 0.0) throw std::logic_error("wrong simplify_tolerance"s);
+    }
+
     return render_settings;
 }
 
@@ -159,133 +796,169 @@ transport::Router JsonReader::FillRoutingSettings(const json::Node& settings) co
     return transport::Router{ settings.AsDict().at("bus_wait_time"s).AsInt(), settings.AsDict().at("bus_velocity"s).AsDouble() };
 }
 
-const json::Node JsonReader::PrintRoute(const json::Dict& request_map, RequestHandler& rh) const {
-    json::Node result;
-    const std::string& route_number = request_map.at("name"s).AsString();
-    const int id = request_map.at("id"s).AsInt();
+// Ключи ответов пишутся по алфавиту, как их упорядочивал json::Dict
+void JsonReader::Print(const transport::BusRequest& request, RequestHandler& rh, json::Writer& writer) const {
+    if (!rh.IsBusNumber(request.name)) {
+        WriteNotFound(request.id, writer);
+        return;
+    }
+    const auto& route_info = rh.GetBusStatata(request.name);
+    writer.StartDict()
+        .Key("curvature"sv).Value(route_info->curvature)
+        .Key("request_id"sv).Value(request.id)
+        .Key("route_length"sv).Value(route_info->route_length)
+        .Key("stop_count"sv).Value(static_cast<int>(route_info->stops_count))
+        .Key("unique_stop_count"sv).Value(static_cast<int>(route_info->unique_stops_count))
+    .EndDict();
+}
 
-    if (!rh.IsBusNumber(route_number)) {
-        result = json::Builder{}
-            .StartDict()
-                .Key("request_id"s).Value(id)
-                .Key("error_message"s).Value("not found"s)
-            .EndDict()
-        .Build();
+void JsonReader::Print(const transport::StopRequest& request, RequestHandler& rh, json::Writer& writer) const {
+    if (!rh.IsStopName(request.name)) {
+        WriteNotFound(request.id, writer);
+        return;
     }
-    else {
-        const auto& route_info = rh.GetBusStatata(route_number);
-        result = json::Builder{}
-            .StartDict()
-                .Key("request_id"s).Value(id)
-                .Key("curvature"s).Value(route_info->curvature)
-                .Key("route_length"s).Value(route_info->route_length)
-                .Key("stop_count"s).Value(static_cast<int>(route_info->stops_count))
-                .Key("unique_stop_count"s).Value(static_cast<int>(route_info->unique_stops_count))
-            .EndDict()
-        .Build();
-    }
-    return result;
-}
-
-const json::Node JsonReader::PrintStop(const json::Dict& request_map, RequestHandler& rh) const {
-    json::Node result;
-    const std::string& stop_name = request_map.at("name"s).AsString();
-    const int id = request_map.at("id"s).AsInt();
-
-    if (!rh.IsStopName(stop_name)) {
-        result = json::Builder{}
-            .StartDict()
-                .Key("request_id"s).Value(id)
-                .Key("error_message"s).Value("not found"s)
-            .EndDict()
-        .Build();
+    writer.StartDict().Key("buses"sv).StartArray();
+    for (const auto& bus : rh.GetBusesByStop(request.name)) {
+        writer.Value(bus);
+    }
+    writer.EndArray()
+        .Key("request_id"sv).Value(request.id)
+    .EndDict();
+}
+
+void JsonReader::Print(const transport::MapRequest& request, RequestHandler& rh, json::Writer& writer) const {
+    writer.StartDict().Key("map"sv);
+    if (request.viewport || request.zoom) {
+        writer.Value(std::string_view(rh.RenderMap(renderer::MapView{ request.viewport, request.zoom })));
     }
     else {
-        json::Array buses;
-        for (const auto& bus : rh.GetBusesByStop(stop_name)) {
-            buses.push_back(bus);
-        }
-        result = json::Builder{}
-            .StartDict()
-                .Key("request_id"s).Value(id)
-                .Key("buses"s).Value(buses)
-            .EndDict()
-        .Build();
-    }
-    return result;
-}
-
-const json::Node JsonReader::PrintMap(const json::Dict& request_map, RequestHandler& rh) const {
-    json::Node result;
-    const int id = request_map.at("id"s).AsInt();
-    std::ostringstream strm;
-    svg::Document map = rh.RenderMap();
-    map.Render(strm);
-
-    result = json::Builder{}
-        .StartDict()
-            .Key("request_id"s).Value(id)
-            .Key("map"s).Value(strm.str())
-        .EndDict()
-    .Build();
-
-    return result;
-}
-
-const json::Node JsonReader::PrintRouting(const json::Dict& request_map, RequestHandler& rh) const {
-    json::Node result;
-    const int id = request_map.at("id"s).AsInt();
-    const std::string_view stop_from = request_map.at("from"s).AsString();
-    const std::string_view stop_to = request_map.at("to"s).AsString();
-    const auto& routing = rh.GetOptimalRoute(stop_from, stop_to);
-    
+        writer.RawValue(rh.GetMapJson());
+    }
+    writer.Key("request_id"sv).Value(request.id)
+    .EndDict();
+}
+
+void JsonReader::Print(const transport::RouteRequest& request, RequestHandler& rh, json::Writer& writer) const {
+    const auto& routing = rh.GetOptimalRoute(request.from, request.to);
+    if (!routing) {
+        WriteNotFound(request.id, writer);
+        return;
+    }
+
+    double total_time = 0.0;
+    writer.StartDict().Key("items"sv).StartArray();
+    for (auto& edge_id : routing.value().edges) {
+        const graph::Edge<double>& edge = rh.GetRouterGraph().GetEdge(edge_id);
+        PrintRouteItem(edge, writer);
+        total_time += edge.weight;
+    }
+    writer.EndArray()
+        .Key("request_id"sv).Value(request.id)
+        .Key("total_time"sv).Value(total_time)
+    .EndDict();
+}
+
+void JsonReader::Print(const transport::NearestStopsRequest& request, RequestHandler& rh, json::Writer& writer) const {
+    writer.StartDict()
+        .Key("request_id"sv).Value(request.id)
+        .Key("stops"sv).StartArray();
+    for (const auto& [stop, distance] : rh.GetNearestStops(request.center, request.radius, static_cast<size_t>(std::max(request.limit, 0)))) {
+        writer.StartDict()
+            .Key("distance"sv).Value(distance)
+            .Key("name"sv).Value(stop->name)
+        .EndDict();
+    }
+    writer.EndArray().EndDict();
+}
+
+void JsonReader::Print(const transport::StopSearchRequest& request, RequestHandler& rh, json::Writer& writer) const {
+    writer.StartDict()
+        .Key("request_id"sv).Value(request.id)
+        .Key("stops"sv).StartArray();
+    for (const auto& [stop, edits] : rh.SearchStops(request.prefix, static_cast<uint32_t>(std::max(request.max_edits, 0)), static_cast<size_t>(std::max(request.limit, 0)))) {
+        writer.StartDict()
+            .Key("edits"sv).Value(static_cast<int>(edits))
+            .Key("name"sv).Value(stop->name)
+        .EndDict();
+    }
+    writer.EndArray().EndDict();
+}
+
+void JsonReader::Print(const transport::CoordinatesRouteRequest& request, RequestHandler& rh, json::Writer& writer) const {
+    const auto& routing = rh.GetOptimalRoute(request.from, request.to, request.walking_speed);
     if (!routing) {
-        result = json::Builder{}
-            .StartDict()
-                .Key("request_id"s).Value(id)
-                .Key("error_message"s).Value("not found"s)
-            .EndDict()
-        .Build();
+        WriteNotFound(request.id, writer);
+        return;
+    }
+
+    writer.StartDict().Key("items"sv).StartArray();
+    if (routing->origin_stop.empty()) {
+        PrintWalkItem({}, routing->total_time, writer);
     }
     else {
-        json::Array items;
-        double total_time = 0.0;
-        items.reserve(routing.value().edges.size());
-        for (auto& edge_id : routing.value().edges) {
-            const graph::Edge<double> edge = rh.GetRouterGraph().GetEdge(edge_id);
-            if (edge.quality == 0) {
-                items.emplace_back(json::Node(json::Builder{}
-                    .StartDict()
-                        .Key("stop_name"s).Value(edge.name)
-                        .Key("time"s).Value(edge.weight)
-                        .Key("type"s).Value("Wait"s)
-                    .EndDict()
-                .Build()));
-
-                total_time += edge.weight;
-            }
-            else {
-                items.emplace_back(json::Node(json::Builder{}
-                    .StartDict()
-                        .Key("bus"s).Value(edge.name)
-                        .Key("span_count"s).Value(static_cast<int>(edge.quality))
-                        .Key("time"s).Value(edge.weight)
-                        .Key("type"s).Value("Bus"s)
-                    .EndDict()
-                .Build()));
-
-                total_time += edge.weight;
-            }
+        PrintWalkItem(routing->origin_stop, routing->origin_walk_time, writer);
+        for (auto& edge_id : routing->edges) {
+            PrintRouteItem(rh.GetRouterGraph().GetEdge(edge_id), writer);
         }
+        PrintWalkItem(routing->destination_stop, routing->destination_walk_time, writer);
+    }
+    writer.EndArray()
+        .Key("request_id"sv).Value(request.id)
+        .Key("total_time"sv).Value(routing->total_time)
+    .EndDict();
+}
 
-        result = json::Builder{}
-            .StartDict()
-                .Key("request_id"s).Value(id)
-                .Key("total_time"s).Value(total_time)
-                .Key("items"s).Value(items)
-            .EndDict()
-        .Build();
+void JsonReader::Print(const transport::CommonBusesRequest& request, RequestHandler& rh, json::Writer& writer) const {
+    const auto& common_buses = rh.GetCommonBuses(request.stops);
+    if (!common_buses) {
+        WriteNotFound(request.id, writer);
+        return;
     }
+    writer.StartDict().Key("buses"sv).StartArray();
+    for (const auto& bus : *common_buses) {
+        writer.Value(bus);
+    }
+    writer.EndArray()
+        .Key("request_id"sv).Value(request.id)
+    .EndDict();
+}
+
+void JsonReader::Print(const transport::RouteSegmentRequest& request, RequestHandler& rh, json::Writer& writer) const {
+    const auto& segment = rh.GetRouteSegmentStat(request.bus, request.from, request.to);
+    if (!segment) {
+        WriteNotFound(request.id, writer);
+        return;
+    }
+    writer.StartDict()
+        .Key("geographic_length"sv).Value(segment->geographic_length)
+        .Key("request_id"sv).Value(request.id)
+        .Key("route_length"sv).Value(segment->route_length)
+        .Key("span_count"sv).Value(static_cast<int>(segment->span_count))
+    .EndDict();
+}
+
+void JsonReader::PrintRouteItem(const graph::Edge<double>& edge, json::Writer& writer) const {
+    writer.StartDict();
+    if (edge.quality == 0) {
+        writer.Key("stop_name"sv).Value(edge.name)
+            .Key("time"sv).Value(edge.weight)
+            .Key("type"sv).Value("Wait"sv);
+    }
+    else {
+        writer.Key("bus"sv).Value(edge.name)
+            .Key("span_count"sv).Value(static_cast<int>(edge.quality))
+            .Key("time"sv).Value(edge.weight)
+            .Key("type"sv).Value("Bus"sv);
+    }
+    writer.EndDict();
+}
 
-    return result;
-}
\ No newline at end of file
+void JsonReader::PrintWalkItem(std::string_view stop_name, double time, json::Writer& writer) const {
+    writer.StartDict();
+    if (!stop_name.empty()) {
+        writer.Key("stop_name"sv).Value(stop_name);
+    }
+    writer.Key("time"sv).Value(time)
+        .Key("type"sv).Value("Walk"sv)
+    .EndDict();
+}
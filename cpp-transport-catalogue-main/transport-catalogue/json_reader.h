@@ -1,40 +1,59 @@
 #pragma once
 
 #include "json.h"
+#include "json_writer.h"
 #include "transport_catalogue.h"
+#include "catalogue_builder.h"
 #include "map_renderer.h"
 #include "request_handler.h"
+#include "stat_request.h"
 
 #include <iostream>
 
 class JsonReader {
 public:
     JsonReader(std::istream& input)
-        : input_(json::Load(input))
+        : input_(json::LoadBuffer(input))
     {}
 
-    const json::Node& GetBaseRequests() const;
+    explicit JsonReader(json::Document input)
+        : input_(std::move(input))
+    {}
+
+    // Читает вход make_base, не собирая base_requests в документ. При jobs == 1 — одним потоковым
+    // проходом, иначе вход читается целиком, а части base_requests разбираются в jobs потоках.
+    // Каталог в обоих случаях получается одинаковым
+    static std::pair<JsonReader, transport::TransportCatalogue> ReadBase(std::istream& input, size_t jobs = 1);
+
     const json::Node& GetStatRequests() const;
     const json::Node& GetRenderSettings() const;
     const json::Node& GetRoutingSettings() const;
     const json::Node& GetSerializationSettings() const;
 
-    void ProcessRequests(const json::Node& stat_requests, RequestHandler& rh) const;
+    void ProcessRequests(const json::Node& stat_requests, RequestHandler& rh, const json::WriterOptions& output_options) const;
+    // Построчный режим: каждая непустая строка input — один запрос, ответ на неё — одна строка вывода.
+    // Каждую строку обслуживает снимок, опубликованный к её началу
+    void ProcessRequestStream(std::istream& input, const transport::SnapshotHolder& snapshots, const json::WriterOptions& output_options) const;
 
-    void FillCatalogue(transport::TransportCatalogue& catalogue);
     renderer::MapRenderer FillRenderSettings(const json::Node& settings) const;
     transport::Router FillRoutingSettings(const json::Node& settings) const;
 
-    const json::Node PrintRoute(const json::Dict& request_map, RequestHandler& rh) const;
-    const json::Node PrintStop(const json::Dict& request_map, RequestHandler& rh) const;
-    const json::Node PrintMap(const json::Dict& request_map, RequestHandler& rh) const;
-    const json::Node PrintRouting(const json::Dict& request_map, RequestHandler& rh) const;
-
 private:
     json::Document input_;
     json::Node dummy_ = nullptr;
 
-    std::tuple<std::string_view, geo::Coordinates, std::map<std::string_view, int>> FillStop(const json::Dict& request_map) const;
-    void FillStopDistances(transport::TransportCatalogue& catalogue) const;
-    std::tuple<std::string_view, std::vector<const transport::Stop*>, bool> FillRoute(const json::Dict& request_map, transport::TransportCatalogue& catalogue) const;
+    // Возвращает false, если тип запроса неизвестен и ничего не записано
+    bool WriteResponse(const transport::StatRequest& request, RequestHandler& rh, json::Writer& writer) const;
+
+    void Print(const transport::StopRequest& request, RequestHandler& rh, json::Writer& writer) const;
+    void Print(const transport::BusRequest& request, RequestHandler& rh, json::Writer& writer) const;
+    void Print(const transport::MapRequest& request, RequestHandler& rh, json::Writer& writer) const;
+    void Print(const transport::RouteRequest& request, RequestHandler& rh, json::Writer& writer) const;
+    void Print(const transport::CoordinatesRouteRequest& request, RequestHandler& rh, json::Writer& writer) const;
+    void Print(const transport::CommonBusesRequest& request, RequestHandler& rh, json::Writer& writer) const;
+    void Print(const transport::RouteSegmentRequest& request, RequestHandler& rh, json::Writer& writer) const;
+    void Print(const transport::NearestStopsRequest& request, RequestHandler& rh, json::Writer& writer) const;
+    void Print(const transport::StopSearchRequest& request, RequestHandler& rh, json::Writer& writer) const;
+    void PrintRouteItem(const graph::Edge<double>& edge, json::Writer& writer) const;
+    void PrintWalkItem(std::string_view stop_name, double time, json::Writer& writer) const;
 };
\ No newline at end of file
@@ -0,0 +1,356 @@
+#include "json_sax.h"
+#include "json_scan.h"
+
+#include <charconv>
+
+namespace json {
+
+namespace {
+
+using namespace std::literals;
+
+class StreamParser {
+public:
+    StreamParser(std::istream& input, SaxHandler& handler)
+        : input_(input)
+        , handler_(handler)
+        , buffer_(BUFFER_SIZE)
+    {
+    }
+
+    void Parse() {
+        ParseValue(NextChar());
+        if (SkipSpaces() != EOF) {
+            throw ParsingError("Unexpected data after JSON value"s);
+        }
+    }
+
+private:
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    std::istream& input_;
+    SaxHandler& handler_;
+    std::vector<char> buffer_;
+    size_t pos_ = 0;
+    size_t end_ = 0;
+    // Строка или число, оказавшиеся на границе блоков, собираются здесь
+    std::string scratch_;
+
+    static bool IsSpace(int c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+    }
+
+    static bool IsDigit(int c) {
+        return c >= '0' && c <= '9';
+    }
+
+    bool Refill() {
+        input_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        pos_ = 0;
+        end_ = static_cast<size_t>(input_.gcount());
+        return end_ > 0;
+    }
+
+    int Peek() {
+        if (pos_ == end_ && !Refill()) {
+            return EOF;
+        }
+        return static_cast<unsigned char>(buffer_[pos_]);
+    }
+
+    int SkipSpaces() {
+        int c = Peek();
+        while (c != EOF && IsSpace(c)) {
+            ++pos_;
+            c = Peek();
+        }
+        return c;
+    }
+
+    // Возвращает следующий значащий символ и сдвигается за него
+    char NextChar() {
+        const int c = SkipSpaces();
+        if (c == EOF) {
+            throw ParsingError("Unexpected EOF"s);
+        }
+        ++pos_;
+        return static_cast<char>(c);
+    }
+
+    void ParseValue(char c) {
+        switch (c) {
+        case '[':
+            ParseArray();
+            break;
+        case '{':
+            ParseDict();
+            break;
+        case '"':
+            handler_.String(ParseString());
+            break;
+        case 't':
+        case 'f':
+        case 'n':
+            ParseLiteral(c);
+            break;
+        default:
+            ParseNumber(c);
+            break;
+        }
+    }
+
+    void ParseArray() {
+        handler_.StartArray();
+        for (char c = NextChar(); c != ']'; c = NextChar()) {
+            if (c == ',') {
+                c = NextChar();
+            }
+            ParseValue(c);
+        }
+        handler_.EndArray();
+    }
+
+    void ParseDict() {
+        handler_.StartDict();
+        for (char c = NextChar(); c != '}'; c = NextChar()) {
+            if (c == ',') {
+                continue;
+            }
+            if (c != '"') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+            handler_.Key(ParseString());
+            if (c = NextChar(); c != ':') {
+                throw ParsingError(": is expected but '"s + c + "' has been found"s);
+            }
+            ParseValue(NextChar());
+        }
+        handler_.EndDict();
+    }
+
+    // Строка целиком внутри блока отдаётся без копирования, иначе собирается в scratch_
+    std::string_view ParseString() {
+        const char* data = buffer_.data();
+        size_t run = FindStringSpecial(data + pos_, data + end_) - data;
+        if (run != end_ && buffer_[run] == '"') {
+            const std::string_view result(data + pos_, run - pos_);
+            pos_ = run + 1;
+            return result;
+        }
+
+        scratch_.clear();
+        while (true) {
+            scratch_.append(buffer_.data() + pos_, run - pos_);
+            pos_ = run;
+            const int ch = Peek();
+            if (ch == EOF) {
+                throw ParsingError("String parsing error"s);
+            }
+            ++pos_;
+            if (ch == '"') {
+                return scratch_;
+            }
+            if (ch == '\n' || ch == '\r') {
+                throw ParsingError("Unexpected end of line"s);
+            }
+            if (ch == '\\') {
+                const int escaped_char = Peek();
+                if (escaped_char == EOF) {
+                    throw ParsingError("String parsing error"s);
+                }
+                ++pos_;
+                switch (escaped_char) {
+                case 'n':
+                    scratch_.push_back('\n');
+                    break;
+                case 't':
+                    scratch_.push_back('\t');
+                    break;
+                case 'r':
+                    scratch_.push_back('\r');
+                    break;
+                case '"':
+                    scratch_.push_back('"');
+                    break;
+                case '\\':
+                    scratch_.push_back('\\');
+                    break;
+                default:
+                    throw ParsingError("Unrecognized escape sequence \\"s + static_cast<char>(escaped_char));
+                }
+            }
+            else {
+                // Обычный символ, прочитанный после подгрузки нового блока
+                scratch_.push_back(static_cast<char>(ch));
+            }
+            // Peek мог подгрузить новый блок, поэтому начало участка берётся заново
+            run = FindStringSpecial(buffer_.data() + pos_, buffer_.data() + end_) - buffer_.data();
+        }
+    }
+
+    void ParseLiteral(char first) {
+        scratch_.assign(1, first);
+        for (int c = Peek(); (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); c = Peek()) {
+            scratch_.push_back(static_cast<char>(c));
+            ++pos_;
+        }
+        if (scratch_ == "true"sv) {
+            handler_.Bool(true);
+        }
+        else if (scratch_ == "false"sv) {
+            handler_.Bool(false);
+        }
+        else if (scratch_ == "null"sv) {
+            handler_.Null();
+        }
+        else {
+            throw ParsingError("Failed to parse '"s + scratch_ + "' as literal"s);
+        }
+    }
+
+    void ReadDigits() {
+        if (!IsDigit(Peek())) {
+            throw ParsingError("A digit is expected"s);
+        }
+        for (int c = Peek(); IsDigit(c); c = Peek()) {
+            scratch_.push_back(static_cast<char>(c));
+            ++pos_;
+        }
+    }
+
+    void ParseNumber(char first) {
+        scratch_.assign(1, first);
+        if (first == '-') {
+            if (Peek() == '0') {
+                scratch_.push_back('0');
+                ++pos_;
+            }
+            else {
+                ReadDigits();
+            }
+        }
+        else if (!IsDigit(first)) {
+            throw ParsingError("A digit is expected"s);
+        }
+        else if (first != '0') {
+            for (int c = Peek(); IsDigit(c); c = Peek()) {
+                scratch_.push_back(static_cast<char>(c));
+                ++pos_;
+            }
+        }
+
+        bool is_int = true;
+        if (Peek() == '.') {
+            scratch_.push_back('.');
+            ++pos_;
+            ReadDigits();
+            is_int = false;
+        }
+        if (const int c = Peek(); c == 'e' || c == 'E') {
+            scratch_.push_back(static_cast<char>(c));
+            ++pos_;
+            if (const int sign = Peek(); sign == '+' || sign == '-') {
+                scratch_.push_back(static_cast<char>(sign));
+                ++pos_;
+            }
+            ReadDigits();
+            is_int = false;
+        }
+
+        const char* begin = scratch_.data();
+        const char* end = begin + scratch_.size();
+        if (is_int) {
+            int value = 0;
+            if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc() && ptr == end) {
+                handler_.Int(value);
+                return;
+            }
+        }
+        double value = 0.0;
+        if (const auto [ptr, ec] = std::from_chars(begin, end, value); ec == std::errc() && ptr == end) {
+            handler_.Double(value);
+            return;
+        }
+        throw ParsingError("Failed to convert "s + scratch_ + " to number"s);
+    }
+};
+
+} // namespace
+
+void ParseSax(std::istream& input, SaxHandler& handler) {
+    StreamParser(input, handler).Parse();
+}
+
+void NodeBuilder::Null() {
+    if (depth_ == 0) {
+        null_root_ = true;
+    }
+    else {
+        builder_->Value(nullptr);
+    }
+    OnValue();
+}
+
+void NodeBuilder::Bool(bool value) {
+    builder_->Value(value);
+    OnValue();
+}
+
+void NodeBuilder::Int(int value) {
+    builder_->Value(value);
+    OnValue();
+}
+
+void NodeBuilder::Double(double value) {
+    builder_->Value(value);
+    OnValue();
+}
+
+void NodeBuilder::String(std::string_view value) {
+    builder_->Value(std::string(value));
+    OnValue();
+}
+
+void NodeBuilder::StartArray() {
+    builder_->StartArray();
+    ++depth_;
+}
+
+void NodeBuilder::EndArray() {
+    builder_->EndArray();
+    --depth_;
+    OnValue();
+}
+
+void NodeBuilder::StartDict() {
+    builder_->StartDict();
+    ++depth_;
+}
+
+void NodeBuilder::Key(std::string_view key) {
+    builder_->Key(std::string(key));
+}
+
+void NodeBuilder::EndDict() {
+    builder_->EndDict();
+    --depth_;
+    OnValue();
+}
+
+bool NodeBuilder::IsComplete() const {
+    return complete_;
+}
+
+Node NodeBuilder::Extract() {
+    Node result = null_root_ ? Node{ nullptr } : builder_->Build();
+    builder_.emplace();
+    complete_ = false;
+    null_root_ = false;
+    return result;
+}
+
+void NodeBuilder::OnValue() {
+    complete_ = depth_ == 0;
+}
+
+} // namespace json
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "json.h"
+#include "json_builder.h"
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+/*
+    * Получатель событий потокового разбора.
+    * Строки и ключи передаются как string_view, действительный только на время вызова
+    */
+class SaxHandler {
+public:
+    virtual ~SaxHandler() = default;
+
+    virtual void Null() = 0;
+    virtual void Bool(bool value) = 0;
+    virtual void Int(int value) = 0;
+    virtual void Double(double value) = 0;
+    virtual void String(std::string_view value) = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void StartDict() = 0;
+    virtual void Key(std::string_view key) = 0;
+    virtual void EndDict() = 0;
+};
+
+// Разбирает поток блоками фиксированного размера, не собирая документ в памяти
+void ParseSax(std::istream& input, SaxHandler& handler);
+
+// Собирает узел из событий: для небольших разделов, которые удобнее читать деревом
+class NodeBuilder final : public SaxHandler {
+public:
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+    void StartArray() override;
+    void EndArray() override;
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+
+    // Узел готов, когда закрыт последний открытый контейнер или получено скалярное значение
+    bool IsComplete() const;
+    Node Extract();
+
+private:
+    void OnValue();
+
+    // Builder хранит указатели на свой корень, поэтому для нового узла он пересоздаётся на месте
+    std::optional<Builder> builder_{ std::in_place };
+    size_t depth_ = 0;
+    bool complete_ = false;
+    // Builder не собирает документ из одного null, поэтому такой корень отмечается отдельно
+    bool null_root_ = false;
+};
+
+} // namespace json
@@ -0,0 +1,230 @@
+#include "json_writer.h"
+#include "json_scan.h"
+
+#include <charconv>
+
+namespace json {
+
+using namespace std::literals;
+
+Writer::Writer(std::ostream& output, WriterOptions options)
+    : output_(output)
+    , compact_(options.compact)
+    , precision_(options.precision)
+{
+    buffer_.reserve(FLUSH_SIZE);
+}
+
+Writer::~Writer() {
+    Flush();
+}
+
+Writer& Writer::StartArray() {
+    BeforeValue();
+    buffer_ += compact_ ? "["sv : "[\n"sv;
+    levels_.push_back({ false, true });
+    return *this;
+}
+
+Writer& Writer::EndArray() {
+    if (levels_.empty() || levels_.back().is_dict) {
+        throw std::logic_error("EndArray() called outside of array"s);
+    }
+    levels_.pop_back();
+    if (!compact_) {
+        buffer_ += '\n';
+        WriteIndent(levels_.size());
+    }
+    buffer_ += ']';
+    AfterValue();
+    return *this;
+}
+
+Writer& Writer::StartDict() {
+    BeforeValue();
+    buffer_ += compact_ ? "{"sv : "{\n"sv;
+    levels_.push_back({ true, true });
+    return *this;
+}
+
+Writer& Writer::EndDict() {
+    if (levels_.empty() || !levels_.back().is_dict) {
+        throw std::logic_error("EndDict() called outside of dict"s);
+    }
+    levels_.pop_back();
+    if (!compact_) {
+        buffer_ += '\n';
+        WriteIndent(levels_.size());
+    }
+    buffer_ += '}';
+    AfterValue();
+    return *this;
+}
+
+Writer& Writer::Key(std::string_view key) {
+    if (levels_.empty() || !levels_.back().is_dict) {
+        throw std::logic_error("Key() called outside of dict"s);
+    }
+    Level& level = levels_.back();
+    if (!level.is_empty) {
+        buffer_ += compact_ ? ","sv : ",\n"sv;
+    }
+    level.is_empty = false;
+    if (!compact_) {
+        WriteIndent(levels_.size());
+    }
+    WriteString(key);
+    buffer_ += compact_ ? ":"sv : ": "sv;
+    return *this;
+}
+
+Writer& Writer::Value(std::nullptr_t) {
+    BeforeValue();
+    buffer_ += "null"sv;
+    AfterValue();
+    return *this;
+}
+
+Writer& Writer::Value(bool value) {
+    BeforeValue();
+    buffer_ += value ? "true"sv : "false"sv;
+    AfterValue();
+    return *this;
+}
+
+Writer& Writer::Value(int value) {
+    BeforeValue();
+    char chars[16];
+    const auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), value);
+    buffer_.append(chars, end);
+    AfterValue();
+    return *this;
+}
+
+Writer& Writer::Value(double value) {
+    BeforeValue();
+    char chars[64];
+    const auto [end, ec] = precision_
+        ? std::to_chars(chars, chars + sizeof(chars), value, std::chars_format::general, *precision_)
+        : std::to_chars(chars, chars + sizeof(chars), value);
+    buffer_.append(chars, end);
+    AfterValue();
+    return *this;
+}
+
+Writer& Writer::Value(std::string_view value) {
+    BeforeValue();
+    WriteString(value);
+    AfterValue();
+    return *this;
+}
+
+Writer& Writer::Value(const char* value) {
+    return Value(std::string_view(value));
+}
+
+Writer& Writer::Value(const Node& node) {
+    if (node.IsArray()) {
+        StartArray();
+        for (const Node& item : node.AsArray()) {
+            Value(item);
+        }
+        return EndArray();
+    }
+    if (node.IsDict()) {
+        StartDict();
+        for (const auto& [key, item] : node.AsDict()) {
+            Key(key).Value(item);
+        }
+        return EndDict();
+    }
+    if (node.IsString()) {
+        return Value(node.AsString());
+    }
+    if (node.IsBool()) {
+        return Value(node.AsBool());
+    }
+    if (node.IsInt()) {
+        return Value(node.AsInt());
+    }
+    if (node.IsPureDouble()) {
+        return Value(node.AsDouble());
+    }
+    return Value(nullptr);
+}
+
+Writer& Writer::RawValue(std::string_view json_text) {
+    BeforeValue();
+    buffer_ += json_text;
+    AfterValue();
+    return *this;
+}
+
+Writer& Writer::EndLine() {
+    if (!levels_.empty()) {
+        throw std::logic_error("EndLine() called inside of container"s);
+    }
+    buffer_ += '\n';
+    AfterValue();
+    return *this;
+}
+
+void Writer::Flush() {
+    output_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+}
+
+// Элемент массива отделяется от предыдущего, значение после ключа пишется сразу
+void Writer::BeforeValue() {
+    if (levels_.empty() || levels_.back().is_dict) {
+        return;
+    }
+    Level& level = levels_.back();
+    if (!level.is_empty) {
+        buffer_ += compact_ ? ","sv : ",\n"sv;
+    }
+    level.is_empty = false;
+    if (!compact_) {
+        WriteIndent(levels_.size());
+    }
+}
+
+void Writer::AfterValue() {
+    if (buffer_.size() >= FLUSH_SIZE) {
+        Flush();
+    }
+}
+
+void Writer::WriteIndent(size_t depth) {
+    buffer_.append(depth * INDENT_STEP, ' ');
+}
+
+void Writer::WriteString(std::string_view value) {
+    buffer_ += '"';
+    const char* pos = value.data();
+    const char* const end = pos + value.size();
+    while (true) {
+        // Участок без символов, требующих экранирования, дописывается одним куском
+        const char* special = FindStringSpecial(pos, end);
+        buffer_.append(pos, special);
+        if (special == end) {
+            break;
+        }
+        switch (*special) {
+        case '\r':
+            buffer_ += "\\r"sv;
+            break;
+        case '\n':
+            buffer_ += "\\n"sv;
+            break;
+        default:
+            buffer_ += '\\';
+            buffer_ += *special;
+            break;
+        }
+        pos = special + 1;
+    }
+    buffer_ += '"';
+}
+
+} // namespace json
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "json.h"
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace json {
+
+struct WriterOptions {
+    // Без отступов и переводов строк
+    bool compact = false;
+    // Число значащих цифр для double, без значения — кратчайшая запись, которая читается обратно без потерь
+    std::optional<int> precision;
+};
+
+/*
+    * Потоковая запись JSON в буфер, который сбрасывается в поток крупными блоками.
+    * Значения пишутся сразу по мере вызовов, документ целиком в памяти не собирается.
+    * Числа форматируются через std::to_chars и не зависят от локали и состояния потока.
+    * Ключи словаря выводятся в порядке вызовов Key
+    */
+class Writer {
+public:
+    explicit Writer(std::ostream& output, WriterOptions options = {});
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator=(const Writer&) = delete;
+
+    Writer& StartArray();
+    Writer& EndArray();
+    Writer& StartDict();
+    Writer& EndDict();
+    Writer& Key(std::string_view key);
+
+    Writer& Value(std::nullptr_t);
+    Writer& Value(bool value);
+    Writer& Value(int value);
+    Writer& Value(double value);
+    Writer& Value(std::string_view value);
+    Writer& Value(const char* value);
+    Writer& Value(const Node& node);
+    // Пишет как есть значение, заранее закодированное в JSON
+    Writer& RawValue(std::string_view json_text);
+
+    // Завершает строку после значения верхнего уровня, нужно для построчного вывода
+    Writer& EndLine();
+
+    void Flush();
+
+private:
+    static constexpr size_t FLUSH_SIZE = 64 * 1024;
+    static constexpr size_t INDENT_STEP = 4;
+
+    struct Level {
+        bool is_dict = false;
+        bool is_empty = true;
+    };
+
+    void BeforeValue();
+    void AfterValue();
+    void WriteIndent(size_t depth);
+    void WriteString(std::string_view value);
+
+    std::ostream& output_;
+    bool compact_;
+    std::optional<int> precision_;
+    std::string buffer_;
+    std::vector<Level> levels_;
+};
+
+} // namespace json
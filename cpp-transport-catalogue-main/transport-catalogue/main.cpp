@@ -1,6 +1,14 @@
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <thread>
 
 #include "transport_catalogue.h"
 #include "json_reader.h"
@@ -8,44 +16,155 @@
 
 using namespace std::literals;
 
+/*
+    * Следит за файлом базы в построчном режиме и после его перезаписи публикует новый снимок.
+    * База загружается в отдельном потоке, запросы тем временем обслуживаются старым снимком.
+    * Файл перечитывается, только когда время его изменения не сдвинулось за интервал опроса,
+    * чтобы не читать базу, которую make_base ещё дописывает. Базу, которая не читается, пропускаем
+    */
+class BaseReloader {
+public:
+    BaseReloader(std::filesystem::path path, transport::SnapshotHolder& snapshots)
+        : path_(std::move(path))
+        , snapshots_(snapshots)
+        , loaded_version_(GetVersion())
+        , thread_([this] { Run(); })
+    {
+    }
+
+    ~BaseReloader() {
+        {
+            std::lock_guard lock(mutex_);
+            stopped_ = true;
+        }
+        stop_condition_.notify_one();
+        thread_.join();
+    }
+
+private:
+    static constexpr std::chrono::seconds POLL_INTERVAL{ 1 };
+
+    std::optional<std::filesystem::file_time_type> GetVersion() const {
+        std::error_code error;
+        const auto version = std::filesystem::last_write_time(path_, error);
+        return error ? std::nullopt : std::optional(version);
+    }
+
+    void Run() {
+        std::unique_lock lock(mutex_);
+        std::optional<std::filesystem::file_time_type> seen_version = loaded_version_;
+        while (!stop_condition_.wait_for(lock, POLL_INTERVAL, [this] { return stopped_; })) {
+            const auto version = GetVersion();
+            if (!version || version == loaded_version_ || version != seen_version) {
+                seen_version = version;
+                continue;
+            }
+            loaded_version_ = version;
+            lock.unlock();
+            try {
+                std::ifstream db_file(path_, std::ios::binary);
+                snapshots_.Publish(serialization::LoadSnapshot(db_file));
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Base reload failed: "sv << e.what() << '\n';
+            }
+            lock.lock();
+        }
+    }
+
+    const std::filesystem::path path_;
+    transport::SnapshotHolder& snapshots_;
+    std::optional<std::filesystem::file_time_type> loaded_version_;
+    std::mutex mutex_;
+    std::condition_variable stop_condition_;
+    bool stopped_ = false;
+    // Объявлен последним: поток запускается, когда остальные поля уже готовы
+    std::thread thread_;
+};
+
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base [--jobs N]|process_requests [--compact] [--shortest] [--ndjson]]\n"sv;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
 
+    // По умолчанию числа выводятся с шестью значащими цифрами, --shortest включает кратчайшую точную запись
+    json::WriterOptions output_options{ false, 6 };
+    bool ndjson = false;
+    // Число потоков разбора base_requests. По умолчанию вход разбирается потоково с постоянной памятью,
+    // --jobs N больше 1 читает вход целиком и делит base_requests между потоками
+    size_t jobs = 1;
+    for (int i = 2; i < argc; ++i) {
+        const std::string_view option(argv[i]);
+        if (mode == "make_base"sv && option == "--jobs"sv && i + 1 < argc) {
+            const std::string_view value(argv[++i]);
+            const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), jobs);
+            if (ec != std::errc() || end != value.data() + value.size() || jobs == 0) {
+                PrintUsage();
+                return 1;
+            }
+        }
+        else if (mode == "process_requests"sv && option == "--compact"sv) {
+            output_options.compact = true;
+        }
+        else if (mode == "process_requests"sv && option == "--shortest"sv) {
+            output_options.precision = std::nullopt;
+        }
+        else if (mode == "process_requests"sv && option == "--ndjson"sv) {
+            ndjson = true;
+        }
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
     if (mode == "make_base"sv) {
-        JsonReader json_input(std::cin);
-        transport::TransportCatalogue catalogue;
-        json_input.FillCatalogue(catalogue);
+        auto [json_input, catalogue] = JsonReader::ReadBase(std::cin, jobs);
+        catalogue.Finalize();
 
-        const auto& routing_settings = json_input.FillRoutingSettings(json_input.GetRoutingSettings());
-        const transport::Router router = { settings, catalogue };
+        transport::Router router = json_input.FillRoutingSettings(json_input.GetRoutingSettings());
+        router.BuildGraph(catalogue);
         const auto& render_settings = json_input.GetRenderSettings();
         const renderer::MapRenderer renderer = json_input.FillRenderSettings(render_settings);
         const auto& serialization_settings = json_input.GetSerializationSettings();
         
-        std::ofstream fout(serialization_settings.AsDict().at("file"s).AsString(), std::ios::binary);
+        std::ofstream fout(std::string(serialization_settings.AsDict().at("file"s).AsString()), std::ios::binary);
         if (fout.is_open()) {
             serialization::Serialize(catalogue, renderer, router, fout);
         }
 }
+    else if (mode == "process_requests"sv && ndjson) {
+        // Первая строка — заголовок с настройками, далее по одному запросу на строку
+        std::ios::sync_with_stdio(false);
+        std::string header;
+        std::getline(std::cin, header);
+        JsonReader json_input(json::LoadBuffer(std::move(header)));
+        const std::string db_path(json_input.GetSerializationSettings().AsDict().at("file"s).AsString());
+        std::ifstream db_file(db_path, std::ios::binary);
+        if (db_file) {
+            transport::SnapshotHolder snapshots(serialization::LoadSnapshot(db_file));
+            db_file.close();
+            BaseReloader reloader(db_path, snapshots);
+
+            json_input.ProcessRequestStream(std::cin, snapshots, output_options);
+        }
+    }
     else if (mode == "process_requests"sv) {
         JsonReader json_input(std::cin);
-        std::ifstream db_file(json_input.GetSerializationSettings().AsDict().at("file"s).AsString(), std::ios::binary);
+        std::ifstream db_file(std::string(json_input.GetSerializationSettings().AsDict().at("file"s).AsString()), std::ios::binary);
         if (db_file) {
-            auto [catalogue, renderer, router, graph, stop_ids] = serialization::Deserialize(db_file);
+            transport::SnapshotHolder snapshots(serialization::LoadSnapshot(db_file));
             const auto& stat_requests = json_input.GetStatRequests();
-            router.SetGraph(graph, stop_ids);
-            RequestHandler rh = { catalogue, renderer, router };
-            
-            json_input.ProcessRequests(stat_requests, rh);
+            RequestHandler rh(snapshots.Get());
+
+            json_input.ProcessRequests(stat_requests, rh, output_options);
         }
     }
     else {
@@ -1,149 +1,389 @@
 #include "map_renderer.h"
 
+#include <future>
+#include <thread>
+
 namespace renderer {
 
+using namespace std::literals;
+
 bool IsZero(double value) {
     return std::abs(value) < EPSILON;
 }
 
-std::vector<svg::Polyline> MapRenderer::GetRouteLines(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const {
-    std::vector<svg::Polyline> result;
-    size_t color_num = 0;
-    for (const auto& [bus_number, bus] : buses) {
-        if (bus->stops.empty()) continue;
-        std::vector<const transport::Stop*> route_stops{ bus->stops.begin(), bus->stops.end() };
-        if (bus->is_circle == false) route_stops.insert(route_stops.end(), std::next(bus->stops.rbegin()), bus->stops.rend());
-        svg::Polyline line;
-        for (const auto& stop : route_stops) {
-            line.AddPoint(sp(stop->coordinates));
+namespace {
+
+// Меньшие части слоёв не окупают запуск потока
+constexpr size_t MIN_CHUNK_OBJECTS = 1024;
+
+// Расстояние от точки до отрезка на плоскости (долгота, широта)
+double ComputeSegmentDistance(geo::Coordinates point, geo::Coordinates from, geo::Coordinates to) {
+    const double dx = to.lng - from.lng;
+    const double dy = to.lat - from.lat;
+    const double length = dx * dx + dy * dy;
+    const double t = length > 0.0
+        ? std::clamp(((point.lng - from.lng) * dx + (point.lat - from.lat) * dy) / length, 0.0, 1.0)
+        : 0.0;
+    return std::hypot(point.lng - from.lng - t * dx, point.lat - from.lat - t * dy);
+}
+
+/*
+    * Вес вершины — наибольший допуск, при котором Douglas–Peucker её ещё сохраняет, у концов он бесконечен.
+    * Вершина делит участок, если её отклонение больше допуска, и остаётся, только если остались все
+    * делившие участки до неё, поэтому вес — минимум отклонений по цепочке делений.
+    * Один проход даёт результат сразу для любого допуска: сохраняются вершины с весом больше него
+    */
+std::vector<double> ComputeSimplificationWeights(const std::vector<geo::Coordinates>& points) {
+    const double infinity = std::numeric_limits<double>::infinity();
+    std::vector<double> weights(points.size(), 0.0);
+    if (points.empty()) {
+        return weights;
+    }
+    weights.front() = weights.back() = infinity;
+
+    struct Range {
+        size_t first;
+        size_t last;
+        double limit;
+    };
+    std::vector<Range> ranges;
+    if (points.size() > 2) {
+        ranges.push_back({ 0, points.size() - 1, infinity });
+    }
+    while (!ranges.empty()) {
+        const Range range = ranges.back();
+        ranges.pop_back();
+
+        size_t farthest = range.first + 1;
+        double max_distance = -1.0;
+        for (size_t i = range.first + 1; i < range.last; ++i) {
+            const double distance = ComputeSegmentDistance(points[i], points[range.first], points[range.last]);
+            if (distance > max_distance) {
+                max_distance = distance;
+                farthest = i;
+            }
+        }
+
+        const double weight = std::min(max_distance, range.limit);
+        weights[farthest] = weight;
+        if (farthest - range.first > 1) {
+            ranges.push_back({ range.first, farthest, weight });
+        }
+        if (range.last - farthest > 1) {
+            ranges.push_back({ farthest, range.last, weight });
         }
-        line.SetStrokeColor(render_settings_.color_palette[color_num]);
-        line.SetFillColor("none");
-        line.SetStrokeWidth(render_settings_.line_width);
-        line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-        line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
+    }
+    return weights;
+}
 
-        if (color_num < (render_settings_.color_palette.size() - 1)) ++color_num;
-        else color_num = 0;
+} // namespace
 
-        result.push_back(line);
+std::string MapRenderer::RenderMap(const MapIndex& index, const MapView& view) const {
+    const SphereProjector sp = GetViewProjector(index.GetBounds(), view);
+    const geo::BoundingBox area = sp.GetVisibleArea(render_settings_.width, render_settings_.height);
+
+    // Наименьший уровень, масштаб которого не мельче масштаба окна, чтобы отклонение не превышало допуск
+    const double base_zoom_coeff = GetBaseZoomCoeff(index.GetBounds());
+    size_t level = 0;
+    while (level <= MAX_ZOOM && std::ldexp(base_zoom_coeff, static_cast<int>(level)) < sp.GetZoomCoeff() * (1 - EPSILON)) {
+        ++level;
+    }
+
+    std::vector<const transport::Stop*> stops;
+    for (const uint32_t position : index.FindStops(area)) {
+        stops.push_back(index.GetStops()[position]);
     }
 
+    std::string result;
+    svg::Writer writer(result, render_settings_.coordinate_precision);
+    writer.StartDocument();
+    WriteMap(result, sp, index, level, index.FindBuses(area), stops, area);
+    writer.EndDocument();
     return result;
 }
 
-std::vector<svg::Text> MapRenderer::GetBusLabel(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const {
-    std::vector<svg::Text> result;
-    size_t color_num = 0;
-    for (const auto& [bus_number, bus] : buses) {
-        if (bus->stops.empty()) continue;
-        svg::Text text;
-        svg::Text underlayer;
-        text.SetPosition(sp(bus->stops[0]->coordinates));
-        text.SetOffset(render_settings_.bus_label_offset);
-        text.SetFontSize(render_settings_.bus_label_font_size);
-        text.SetFontFamily("Verdana");
-        text.SetFontWeight("bold");
-        text.SetData(bus->number);
-        text.SetFillColor(render_settings_.color_palette[color_num]);
-        if (color_num < (render_settings_.color_palette.size() - 1)) ++color_num;
-        else color_num = 0;
-
-        underlayer.SetPosition(sp(bus->stops[0]->coordinates));
-        underlayer.SetOffset(render_settings_.bus_label_offset);
-        underlayer.SetFontSize(render_settings_.bus_label_font_size);
-        underlayer.SetFontFamily("Verdana");
-        underlayer.SetFontWeight("bold");
-        underlayer.SetData(bus->number);
-        underlayer.SetFillColor(render_settings_.underlayer_color);
-        underlayer.SetStrokeColor(render_settings_.underlayer_color);
-        underlayer.SetStrokeWidth(render_settings_.underlayer_width);
-        underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-        underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-
-        result.push_back(underlayer);
-        result.push_back(text);
-
-        if (bus->is_circle == false && bus->stops[0] != bus->stops[bus->stops.size() - 1]) {
-            svg::Text text2 {text};
-            svg::Text underlayer2 {underlayer};
-            text2.SetPosition(sp(bus->stops[bus->stops.size() - 1]->coordinates));
-            underlayer2.SetPosition(sp(bus->stops[bus->stops.size() - 1]->coordinates));
-
-            result.push_back(underlayer2);
-            result.push_back(text2);
+void MapRenderer::WriteMap(std::string& out, const SphereProjector& sp, const MapIndex& index, size_t level,
+    const std::vector<uint32_t>& bus_positions, const std::vector<const transport::Stop*>& stops,
+    const std::optional<geo::BoundingBox>& label_area) const {
+    const std::vector<const transport::Bus*>& buses = index.GetBuses();
+    const std::vector<SimplifiedRoute>& simplified_routes = index.GetSimplifiedRoutes();
+    const MapStyles styles = FormatStyles();
+    const uint32_t bus_font_size = static_cast<uint32_t>(render_settings_.bus_label_font_size);
+    const uint32_t stop_font_size = static_cast<uint32_t>(render_settings_.stop_label_font_size);
+
+    auto write_route_lines = [&](svg::Writer& writer, size_t from, size_t to) {
+        for (size_t i = from; i < to; ++i) {
+            const uint32_t position = bus_positions[i];
+            const transport::Bus* bus = buses[position];
+            writer.StartPolyline();
+            if (!simplified_routes.empty()) {
+                // Обратный ход идёт по тем же точкам, а при скруглённых стыках и концах линия без него выглядит так же
+                const auto& levels = simplified_routes[position].levels;
+                if (level < levels.size()) {
+                    for (const uint32_t stop_index : levels[level]) {
+                        writer.AddPoint(sp(bus->stops[stop_index]->coordinates));
+                    }
+                }
+                else {
+                    for (const transport::Stop* stop : bus->stops) {
+                        writer.AddPoint(sp(stop->coordinates));
+                    }
+                }
+                writer.EndPolyline(styles.lines[position % styles.lines.size()]);
+                continue;
+            }
+            for (const transport::Stop* stop : bus->stops) {
+                writer.AddPoint(sp(stop->coordinates));
+            }
+            if (!bus->is_circle) {
+                for (auto it = std::next(bus->stops.rbegin()); it != bus->stops.rend(); ++it) {
+                    writer.AddPoint(sp((*it)->coordinates));
+                }
+            }
+            writer.EndPolyline(styles.lines[position % styles.lines.size()]);
         }
-    }
+    };
 
-    return result;
+    auto is_labeled = [&label_area](const transport::Stop* stop) {
+        return !label_area || label_area->Contains(stop->coordinates);
+    };
+    auto write_bus_labels = [&](svg::Writer& writer, size_t from, size_t to) {
+        for (size_t i = from; i < to; ++i) {
+            const uint32_t position = bus_positions[i];
+            const transport::Bus* bus = buses[position];
+            const std::string& label_style = styles.bus_labels[position % styles.bus_labels.size()];
+            if (is_labeled(bus->stops.front())) {
+                const svg::Point first = sp(bus->stops.front()->coordinates);
+                writer.Text(first, render_settings_.bus_label_offset, bus_font_size, "Verdana"sv, "bold"sv, bus->number, styles.underlayer);
+                writer.Text(first, render_settings_.bus_label_offset, bus_font_size, "Verdana"sv, "bold"sv, bus->number, label_style);
+            }
+            if (!bus->is_circle && bus->stops.front() != bus->stops.back() && is_labeled(bus->stops.back())) {
+                const svg::Point last = sp(bus->stops.back()->coordinates);
+                writer.Text(last, render_settings_.bus_label_offset, bus_font_size, "Verdana"sv, "bold"sv, bus->number, styles.underlayer);
+                writer.Text(last, render_settings_.bus_label_offset, bus_font_size, "Verdana"sv, "bold"sv, bus->number, label_style);
+            }
+        }
+    };
+
+    auto write_stop_symbols = [&](svg::Writer& writer, size_t from, size_t to) {
+        for (size_t i = from; i < to; ++i) {
+            writer.Circle(sp(stops[i]->coordinates), render_settings_.stop_radius, styles.stop_symbol);
+        }
+    };
+
+    auto write_stop_labels = [&](svg::Writer& writer, size_t from, size_t to) {
+        for (size_t i = from; i < to; ++i) {
+            const svg::Point position = sp(stops[i]->coordinates);
+            writer.Text(position, render_settings_.stop_label_offset, stop_font_size, "Verdana"sv, {}, stops[i]->name, styles.underlayer);
+            writer.Text(position, render_settings_.stop_label_offset, stop_font_size, "Verdana"sv, {}, stops[i]->name, styles.stop_label);
+        }
+    };
+
+    // Слои и их части пишутся в отдельные буферы, а склеиваются строго в порядке слоёв.
+    // Первая часть выполняется в вызывающем потоке, небольшая карта целиком пишется в нём же
+    const size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+    const bool parallel = jobs > 1 && 2 * (bus_positions.size() + stops.size()) >= MIN_CHUNK_OBJECTS;
+    std::vector<std::future<std::string>> chunks;
+    auto add_layer = [&](size_t count, auto write_layer) {
+        const size_t chunk_count = parallel ? std::clamp<size_t>(count / MIN_CHUNK_OBJECTS, 1, jobs) : 1;
+        for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+            const size_t from = count * chunk / chunk_count;
+            const size_t to = count * (chunk + 1) / chunk_count;
+            if (from == to) {
+                continue;
+            }
+            chunks.push_back(std::async(parallel && !chunks.empty() ? std::launch::async : std::launch::deferred,
+                [this, write_layer, from, to] {
+                    std::string buffer;
+                    svg::Writer writer(buffer, render_settings_.coordinate_precision);
+                    write_layer(writer, from, to);
+                    return buffer;
+                }));
+        }
+    };
+    add_layer(bus_positions.size(), write_route_lines);
+    add_layer(bus_positions.size(), write_bus_labels);
+    add_layer(stops.size(), write_stop_symbols);
+    add_layer(stops.size(), write_stop_labels);
+
+    for (auto& chunk : chunks) {
+        out += chunk.get();
+    }
 }
 
-std::vector<svg::Circle> MapRenderer::GetStopsSymbols(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const {
-    std::vector<svg::Circle> result;
-    for (const auto& [stop_name, stop] : stops) {
-        svg::Circle symbol;
-        symbol.SetCenter(sp(stop->coordinates));
-        symbol.SetRadius(render_settings_.stop_radius);
-        symbol.SetFillColor("white");
+SphereProjector MapRenderer::GetViewProjector(const geo::BoundingBox& bounds, const MapView& view) const {
+    const geo::BoundingBox area = view.viewport.value_or(bounds);
+    const std::vector<geo::Coordinates> area_corners = { area.min, area.max };
+    if (!view.zoom) {
+        return SphereProjector(area_corners.begin(), area_corners.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
+    }
 
-        result.push_back(symbol);
+    const double zoom_coeff = std::ldexp(GetBaseZoomCoeff(bounds), std::clamp(*view.zoom, 0, MAX_ZOOM));
+    if (IsZero(zoom_coeff)) {
+        const std::vector<geo::Coordinates> bounds_corners = { bounds.min, bounds.max };
+        return SphereProjector(bounds_corners.begin(), bounds_corners.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
     }
+    // Центр области оказывается в центре холста
+    const geo::Coordinates center = { (area.min.lat + area.max.lat) / 2, (area.min.lng + area.max.lng) / 2 };
+    return SphereProjector({ center.lat + render_settings_.height / 2 / zoom_coeff, center.lng - render_settings_.width / 2 / zoom_coeff }, zoom_coeff, 0.0);
+}
 
-    return result;
+double MapRenderer::GetBaseZoomCoeff(const geo::BoundingBox& bounds) const {
+    const std::vector<geo::Coordinates> bounds_corners = { bounds.min, bounds.max };
+    return SphereProjector(bounds_corners.begin(), bounds_corners.end(), render_settings_.width, render_settings_.height, render_settings_.padding)
+        .GetZoomCoeff();
 }
 
-std::vector<svg::Text> MapRenderer::GetStopsLabels(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const {
-    std::vector<svg::Text> result;
-    svg::Text text;
-    svg::Text underlayer;
-    for (const auto& [stop_name, stop] : stops) {
-        text.SetPosition(sp(stop->coordinates));
-        text.SetOffset(render_settings_.stop_label_offset);
-        text.SetFontSize(render_settings_.stop_label_font_size);
-        text.SetFontFamily("Verdana");
-        text.SetData(stop->name);
-        text.SetFillColor("black");
-
-        underlayer.SetPosition(sp(stop->coordinates));
-        underlayer.SetOffset(render_settings_.stop_label_offset);
-        underlayer.SetFontSize(render_settings_.stop_label_font_size);
-        underlayer.SetFontFamily("Verdana");
-        underlayer.SetData(stop->name);
-        underlayer.SetFillColor(render_settings_.underlayer_color);
-        underlayer.SetStrokeColor(render_settings_.underlayer_color);
-        underlayer.SetStrokeWidth(render_settings_.underlayer_width);
-        underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-        underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-
-        result.push_back(underlayer);
-        result.push_back(text);
+std::vector<SimplifiedRoute> MapRenderer::SimplifyRoutes(const MapIndex& index) const {
+    std::vector<SimplifiedRoute> result;
+    const double base_zoom_coeff = GetBaseZoomCoeff(index.GetBounds());
+    if (render_settings_.simplify_tolerance <= 0.0 || IsZero(base_zoom_coeff)) {
+        return result;
     }
 
+    result.reserve(index.GetBuses().size());
+    std::vector<geo::Coordinates> points;
+    for (const transport::Bus* bus : index.GetBuses()) {
+        points.clear();
+        for (const transport::Stop* stop : bus->stops) {
+            points.push_back(stop->coordinates);
+        }
+        const std::vector<double> weights = ComputeSimplificationWeights(points);
+
+        SimplifiedRoute route;
+        for (int zoom = 0; zoom <= MAX_ZOOM; ++zoom) {
+            // Проекция лишь масштабирует координаты, поэтому допуск в пикселях переводится в градусы
+            const double tolerance = render_settings_.simplify_tolerance / std::ldexp(base_zoom_coeff, zoom);
+            std::vector<uint32_t> kept;
+            for (size_t i = 0; i < weights.size(); ++i) {
+                if (weights[i] > tolerance) {
+                    kept.push_back(static_cast<uint32_t>(i));
+                }
+            }
+            if (kept.size() == points.size()) {
+                break;
+            }
+            route.levels.push_back(std::move(kept));
+        }
+        result.push_back(std::move(route));
+    }
     return result;
 }
 
-svg::Document MapRenderer::GetSVG(const std::map<std::string_view, const transport::Bus*>& buses) const {
-    svg::Document result;
-    std::vector<geo::Coordinates> route_stops_coord;
-    std::map<std::string_view, const transport::Stop*> all_stops;
+MapRenderer::MapStyles MapRenderer::FormatStyles() const {
+    MapStyles styles;
+    // Пустая палитра даёт линии и подписи без цвета вместо обращения за пределы палитры
+    const std::vector<svg::Color> palette = render_settings_.color_palette.empty()
+        ? std::vector<svg::Color>{ svg::NoneColor }
+        : render_settings_.color_palette;
+    for (const svg::Color& color : palette) {
+        styles.lines.push_back(svg::Style()
+            .SetFillColor("none")
+            .SetStrokeColor(color)
+            .SetStrokeWidth(render_settings_.line_width)
+            .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
+            .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
+            .Format());
+        styles.bus_labels.push_back(svg::Style().SetFillColor(color).Format());
+    }
+    styles.underlayer = svg::Style()
+        .SetFillColor(render_settings_.underlayer_color)
+        .SetStrokeColor(render_settings_.underlayer_color)
+        .SetStrokeWidth(render_settings_.underlayer_width)
+        .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
+        .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND)
+        .Format();
+    styles.stop_symbol = svg::Style().SetFillColor("white").Format();
+    styles.stop_label = svg::Style().SetFillColor("black").Format();
+    return styles;
+}
+
+MapIndex::MapIndex(const transport::BusesRange& buses, const transport::StopsRange& stops) {
+    std::vector<geo::BoundingBox> stop_boxes;
+    for (const transport::Stop* stop : stops) {
+        if (stop->bus_ids.empty()) continue;
+        stops_.push_back(stop);
+        stop_boxes.push_back({ stop->coordinates, stop->coordinates });
+    }
+    if (!stop_boxes.empty()) {
+        bounds_ = stop_boxes.front();
+        for (const geo::BoundingBox& box : stop_boxes) {
+            bounds_.Extend(box);
+        }
+    }
 
-    for (const auto& [bus_number, bus] : buses) {
+    // Обратный ход маршрута проходит по тем же отрезкам, поэтому индексируется только прямой
+    std::vector<geo::BoundingBox> segment_boxes;
+    for (const transport::Bus* bus : buses) {
         if (bus->stops.empty()) continue;
-        for (const auto& stop : bus->stops) {
-            route_stops_coord.push_back(stop->coordinates);
-            all_stops[stop->name] = stop;
+        const uint32_t position = static_cast<uint32_t>(buses_.size());
+        buses_.push_back(bus);
+        if (bus->stops.size() == 1) {
+            segment_boxes.push_back({ bus->stops.front()->coordinates, bus->stops.front()->coordinates });
+            segment_buses_.push_back(position);
+        }
+        for (size_t i = 1; i < bus->stops.size(); ++i) {
+            segment_boxes.push_back(geo::MakeBoundingBox(bus->stops[i - 1]->coordinates, bus->stops[i]->coordinates));
+            segment_buses_.push_back(position);
         }
     }
-    SphereProjector sp(route_stops_coord.begin(), route_stops_coord.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
 
-    for (const auto& line : GetRouteLines(buses, sp)) result.Add(line);
-    for (const auto& text : GetBusLabel(buses, sp)) result.Add(text);
-    for (const auto& circle : GetStopsSymbols(all_stops, sp)) result.Add(circle);
-    for (const auto& text : GetStopsLabels(all_stops, sp)) result.Add(text);
+    stop_index_ = geo::BoxIndex(std::move(stop_boxes));
+    segment_index_ = geo::BoxIndex(std::move(segment_boxes));
+}
 
+const std::vector<const transport::Bus*>& MapIndex::GetBuses() const {
+    return buses_;
+}
+
+const std::vector<const transport::Stop*>& MapIndex::GetStops() const {
+    return stops_;
+}
+
+const geo::BoundingBox& MapIndex::GetBounds() const {
+    return bounds_;
+}
+
+std::vector<uint32_t> MapIndex::FindBuses(const geo::BoundingBox& area) const {
+    std::vector<uint32_t> result;
+    for (const uint32_t segment : segment_index_.Find(area)) {
+        result.push_back(segment_buses_[segment]);
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
     return result;
 }
 
+std::vector<uint32_t> MapIndex::FindStops(const geo::BoundingBox& area) const {
+    return stop_index_.Find(area);
+}
+
+void MapIndex::SetSimplifiedRoutes(std::vector<SimplifiedRoute> routes) {
+    // Линии из базы, не совпадающие с маршрутами каталога, отбрасываются целиком
+    const auto matches = [](const SimplifiedRoute& route, const transport::Bus* bus) {
+        for (const auto& level : route.levels) {
+            for (const uint32_t stop_index : level) {
+                if (stop_index >= bus->stops.size()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    bool valid = routes.size() == buses_.size();
+    for (size_t i = 0; valid && i < routes.size(); ++i) {
+        valid = matches(routes[i], buses_[i]);
+    }
+    if (!valid) {
+        routes.clear();
+    }
+    simplified_routes_ = std::move(routes);
+}
+
+const std::vector<SimplifiedRoute>& MapIndex::GetSimplifiedRoutes() const {
+    return simplified_routes_;
+}
+
 const RenderSettings MapRenderer::GetRenderSettings() const {
     return render_settings_;
 }
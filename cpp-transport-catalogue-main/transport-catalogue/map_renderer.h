@@ -4,8 +4,13 @@
 #include "geo.h"
 #include "json.h"
 #include "domain.h"
+#include "spatial_index.h"
 
 #include <algorithm>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
 
 namespace renderer {
 
@@ -55,6 +60,16 @@ public:
             zoom_coeff_ = *height_zoom;
         }
     }
+
+    // Проекция с заданным масштабом, при которой точка top_left попадает в (padding, padding)
+    SphereProjector(geo::Coordinates top_left, double zoom_coeff, double padding)
+        : padding_(padding)
+        , min_lon_(top_left.lng)
+        , max_lat_(top_left.lat)
+        , zoom_coeff_(zoom_coeff)
+    {
+    }
+
     svg::Point operator()(geo::Coordinates coords) const {
         return {
             (coords.lng - min_lon_) * zoom_coeff_ + padding_,
@@ -62,6 +77,23 @@ public:
         };
     }
 
+    // Пикселей на градус, 0 — если все точки совпадают
+    double GetZoomCoeff() const {
+        return zoom_coeff_;
+    }
+
+    // Область, которая попадает на холст width x height. При нулевом масштабе на холст проецируется любая точка
+    geo::BoundingBox GetVisibleArea(double width, double height) const {
+        if (IsZero(zoom_coeff_)) {
+            const double infinity = std::numeric_limits<double>::infinity();
+            return { { -infinity, -infinity }, { infinity, infinity } };
+        }
+        return {
+            { max_lat_ - (height - padding_) / zoom_coeff_, min_lon_ - padding_ / zoom_coeff_ },
+            { max_lat_ + padding_ / zoom_coeff_, min_lon_ + (width - padding_) / zoom_coeff_ }
+        };
+    }
+
 private:
     double padding_;
     double min_lon_ = 0;
@@ -82,27 +114,104 @@ struct RenderSettings {
     svg::Color underlayer_color = { svg::NoneColor };
     double underlayer_width = 0.0;
     std::vector<svg::Color> color_palette {};
+    // Число значащих цифр в координатах и размерах фигур
+    int coordinate_precision = svg::DEFAULT_PRECISION;
+    // Допуск упрощения линий маршрутов в пикселях, 0 — линии не упрощаются
+    double simplify_tolerance = 0.0;
+};
+
+// Линия маршрута после упрощения: levels[z] — номера остановок прямого хода, оставшиеся на уровне масштаба z.
+// Уровни, на которых остаются все остановки, не хранятся
+struct SimplifiedRoute {
+    std::vector<std::vector<uint32_t>> levels;
+};
+
+/*
+    * Пространственный индекс карты: остановки, через которые идут маршруты, и рамки отрезков маршрутов.
+    * Остановки и маршруты нумеруются позициями в отсортированных списках, поэтому отобранные
+    * по окну объекты выводятся в том же порядке и теми же цветами, что и на полной карте
+    */
+class MapIndex {
+public:
+    MapIndex() = default;
+    MapIndex(const transport::BusesRange& buses, const transport::StopsRange& stops);
+
+    // Непустые маршруты и остановки с маршрутами в порядке вывода на карту
+    const std::vector<const transport::Bus*>& GetBuses() const;
+    const std::vector<const transport::Stop*>& GetStops() const;
+    // Рамка всех остановок карты
+    const geo::BoundingBox& GetBounds() const;
+
+    // Позиции маршрутов, хотя бы один отрезок которых задевает area, по возрастанию
+    std::vector<uint32_t> FindBuses(const geo::BoundingBox& area) const;
+    // Позиции остановок внутри area, по возрастанию
+    std::vector<uint32_t> FindStops(const geo::BoundingBox& area) const;
+
+    // Упрощённые линии по одной на маршрут из GetBuses; пустой список — линии выводятся целиком.
+    // Если число линий не совпадает с числом маршрутов или номер остановки выходит за маршрут, список не сохраняется
+    void SetSimplifiedRoutes(std::vector<SimplifiedRoute> routes);
+    const std::vector<SimplifiedRoute>& GetSimplifiedRoutes() const;
+
+private:
+    std::vector<const transport::Bus*> buses_;
+    std::vector<const transport::Stop*> stops_;
+    geo::BoundingBox bounds_ = { { 0.0, 0.0 }, { 0.0, 0.0 } };
+    geo::BoxIndex stop_index_;
+    geo::BoxIndex segment_index_;
+    // Позиция маршрута для каждого отрезка из segment_index_
+    std::vector<uint32_t> segment_buses_;
+    std::vector<SimplifiedRoute> simplified_routes_;
+};
+
+// Окно карты: прямоугольник в координатах и уровень масштаба, каждый из них необязателен
+struct MapView {
+    std::optional<geo::BoundingBox> viewport;
+    std::optional<int> zoom;
 };
 
 class MapRenderer {
 public:
+    // Каждый уровень масштаба вдвое крупнее предыдущего, нулевой — вся сеть
+    static constexpr int MAX_ZOOM = 20;
+
     MapRenderer() {}
 
     MapRenderer(const RenderSettings& render_settings)
         : render_settings_(render_settings)
     {}
 
-    std::vector<svg::Polyline> GetRouteLines(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const;
-    std::vector<svg::Text> GetBusLabel(const std::map<std::string_view, const transport::Bus*>& buses, const SphereProjector& sp) const;
-    std::vector<svg::Circle> GetStopsSymbols(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const;
-    std::vector<svg::Text> GetStopsLabels(const std::map<std::string_view, const transport::Stop*>& stops, const SphereProjector& sp) const;
-
-    svg::Document GetSVG(const std::map<std::string_view, const transport::Bus*>& buses) const;
+    // Окно карты размером width x height. Без zoom проекция вписывает в окно viewport,
+    // с zoom — берёт масштаб полной карты, увеличенный в 2^zoom раз, с центром в центре viewport или всей сети.
+    // Выводятся только объекты, задевающие видимую область вместе с полями padding
+    std::string RenderMap(const MapIndex& index, const MapView& view) const;
+    // Douglas–Peucker в экранных координатах для каждого уровня масштаба: на уровне z вершина сохраняется,
+    // если без неё линия отклонится больше чем на simplify_tolerance пикселей. При нулевом допуске список пуст
+    std::vector<SimplifiedRoute> SimplifyRoutes(const MapIndex& index) const;
 
     const RenderSettings GetRenderSettings() const;
 
 private:
     const RenderSettings render_settings_;
+
+    // Стили, отформатированные один раз на карту: по одному на цвет палитры и общие
+    struct MapStyles {
+        std::vector<std::string> lines;
+        std::vector<std::string> bus_labels;
+        std::string underlayer;
+        std::string stop_symbol;
+        std::string stop_label;
+    };
+
+    MapStyles FormatStyles() const;
+    // Дописывает в out слои карты в порядке вывода, большие слои — по частям в нескольких потоках.
+    // Маршруты заданы позициями в index, подписи маршрутов выводятся только у конечных внутри label_area,
+    // если она задана. Упрощённые линии берутся с уровня level
+    void WriteMap(std::string& out, const SphereProjector& sp, const MapIndex& index, size_t level,
+        const std::vector<uint32_t>& bus_positions, const std::vector<const transport::Stop*>& stops,
+        const std::optional<geo::BoundingBox>& label_area) const;
+    SphereProjector GetViewProjector(const geo::BoundingBox& bounds, const MapView& view) const;
+    // Масштаб полной карты, вписанной в холст
+    double GetBaseZoomCoeff(const geo::BoundingBox& bounds) const;
 };
 
 } // namespace renderer
\ No newline at end of file
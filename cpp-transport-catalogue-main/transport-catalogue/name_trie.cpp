@@ -0,0 +1,208 @@
+#include "name_trie.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace transport {
+
+namespace {
+
+// Длина последовательности UTF-8 по первому байту. Некорректный байт считается отдельным символом
+size_t Utf8Length(char lead) {
+    const auto byte = static_cast<unsigned char>(lead);
+    if (byte >= 0xF0 && byte < 0xF8) {
+        return 4;
+    }
+    if (byte >= 0xE0 && byte < 0xF0) {
+        return 3;
+    }
+    if (byte >= 0xC0 && byte < 0xE0) {
+        return 2;
+    }
+    return 1;
+}
+
+uint32_t AppendByte(uint32_t symbol, char byte) {
+    return (symbol << 8) | static_cast<unsigned char>(byte);
+}
+
+// Символы сравниваются по байтам их кодировки, упакованным в одно число
+std::vector<uint32_t> SplitSymbols(std::string_view text) {
+    std::vector<uint32_t> symbols;
+    for (size_t pos = 0; pos < text.size();) {
+        const size_t end = std::min(text.size(), pos + Utf8Length(text[pos]));
+        uint32_t symbol = 0;
+        for (; pos < end; ++pos) {
+            symbol = AppendByte(symbol, text[pos]);
+        }
+        symbols.push_back(symbol);
+    }
+    return symbols;
+}
+
+} // namespace
+
+struct NameTrie::SearchState {
+    std::vector<uint32_t> query;
+    uint32_t max_edits = 0;
+    size_t limit = 0;
+    // Строки матрицы расстояний Левенштейна для каждой глубины текущего пути подряд
+    std::vector<uint32_t> rows;
+    std::vector<std::vector<uint32_t>> buckets;
+
+    // Имена обходятся в лексикографическом порядке, поэтому новое имя нужно,
+    // только пока вместе с более близкими совпадениями не набрано limit имён
+    bool Accepts(uint32_t edits) const {
+        size_t count = 0;
+        for (uint32_t i = 0; i <= edits; ++i) {
+            count += buckets[i].size();
+        }
+        return count < limit;
+    }
+};
+
+NameTrie::NameTrie(std::vector<std::pair<std::string_view, uint32_t>> keys) {
+    std::stable_sort(keys.begin(), keys.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs.first < rhs.first;
+    });
+
+    struct KeyRange {
+        size_t from;
+        size_t to;
+        size_t depth;
+    };
+    // Узлы нумеруются в порядке обхода в ширину, поэтому рёбра узла добавляются одним блоком
+    std::vector<KeyRange> nodes = { { 0, keys.size(), 0 } };
+    for (size_t node = 0; node < nodes.size(); ++node) {
+        auto [from, to, depth] = nodes[node];
+
+        uint32_t value = NO_VALUE;
+        for (; from < to && keys[from].first.size() == depth; ++from) {
+            if (value == NO_VALUE) {
+                value = keys[from].second;
+            }
+        }
+        table_.values.push_back(value);
+        table_.edge_offsets.push_back(static_cast<uint32_t>(table_.labels.size()));
+
+        while (from < to) {
+            const char label = keys[from].first[depth];
+            size_t end = from;
+            while (end < to && keys[end].first[depth] == label) {
+                ++end;
+            }
+            table_.labels.push_back(label);
+            table_.targets.push_back(static_cast<uint32_t>(nodes.size()));
+            nodes.push_back({ from, end, depth + 1 });
+            from = end;
+        }
+    }
+    table_.edge_offsets.push_back(static_cast<uint32_t>(table_.labels.size()));
+}
+
+NameTrie::NameTrie(Table table)
+    : table_(std::move(table))
+{
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> NameTrie::Search(std::string_view query, uint32_t max_edits, size_t limit) const {
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    if (IsEmpty() || limit == 0) {
+        return result;
+    }
+
+    SearchState state;
+    state.query = SplitSymbols(query);
+    state.max_edits = max_edits;
+    state.limit = limit;
+    state.rows.resize(state.query.size() + 1);
+    std::iota(state.rows.begin(), state.rows.end(), 0u);
+    state.buckets.resize(static_cast<size_t>(max_edits) + 1);
+
+    SearchNode(0, 0, NO_VALUE, state);
+
+    for (uint32_t edits = 0; edits <= max_edits; ++edits) {
+        for (const uint32_t value : state.buckets[edits]) {
+            if (result.size() == limit) {
+                return result;
+            }
+            result.emplace_back(value, edits);
+        }
+    }
+    return result;
+}
+
+const NameTrie::Table& NameTrie::GetTable() const {
+    return table_;
+}
+
+bool NameTrie::IsEmpty() const {
+    return table_.values.empty();
+}
+
+void NameTrie::SearchNode(uint32_t node, size_t depth, uint32_t best, SearchState& state) const {
+    const size_t width = state.query.size() + 1;
+    const size_t row = depth * width;
+    // Расстояние до имени равно минимуму по всем префиксам пути, то есть последних столбцов строк
+    best = std::min(best, state.rows[row + width - 1]);
+    if (best <= state.max_edits && table_.values[node] != NO_VALUE && state.Accepts(best)) {
+        state.buckets[best].push_back(table_.values[node]);
+    }
+
+    // Значения следующих строк не меньше минимума текущей, поэтому дальше расстояние не уменьшится
+    const uint32_t row_min = *std::min_element(state.rows.begin() + row, state.rows.begin() + row + width);
+    if (best <= state.max_edits && row_min >= best) {
+        for (uint32_t edge = table_.edge_offsets[node]; edge < table_.edge_offsets[node + 1]; ++edge) {
+            CollectSubtree(table_.targets[edge], best, state);
+        }
+        return;
+    }
+    if (row_min > state.max_edits) {
+        return;
+    }
+
+    if (state.rows.size() < row + 2 * width) {
+        state.rows.resize(row + 2 * width);
+    }
+    for (uint32_t edge = table_.edge_offsets[node]; edge < table_.edge_offsets[node + 1]; ++edge) {
+        const char label = table_.labels[edge];
+        SearchSymbol(table_.targets[edge], depth, best, AppendByte(0, label), Utf8Length(label) - 1, state);
+    }
+}
+
+void NameTrie::SearchSymbol(uint32_t node, size_t depth, uint32_t best, uint32_t symbol, size_t pending, SearchState& state) const {
+    // Внутри многобайтового символа строка матрицы не считается, пока не дочитаны все его байты
+    if (pending > 0) {
+        for (uint32_t edge = table_.edge_offsets[node]; edge < table_.edge_offsets[node + 1]; ++edge) {
+            SearchSymbol(table_.targets[edge], depth, best, AppendByte(symbol, table_.labels[edge]), pending - 1, state);
+        }
+        return;
+    }
+
+    const size_t width = state.query.size() + 1;
+    const size_t row = depth * width;
+    const size_t next = row + width;
+    state.rows[next] = state.rows[row] + 1;
+    for (size_t j = 1; j < width; ++j) {
+        state.rows[next + j] = std::min({
+            state.rows[row + j] + 1,
+            state.rows[next + j - 1] + 1,
+            state.rows[row + j - 1] + (state.query[j - 1] != symbol)
+        });
+    }
+    SearchNode(node, depth + 1, best, state);
+}
+
+void NameTrie::CollectSubtree(uint32_t node, uint32_t edits, SearchState& state) const {
+    if (!state.Accepts(edits)) {
+        return;
+    }
+    if (table_.values[node] != NO_VALUE) {
+        state.buckets[edits].push_back(table_.values[node]);
+    }
+    for (uint32_t edge = table_.edge_offsets[node]; edge < table_.edge_offsets[node + 1]; ++edge) {
+        CollectSubtree(table_.targets[edge], edits, state);
+    }
+}
+
+} // namespace transport
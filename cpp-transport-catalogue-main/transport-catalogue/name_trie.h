@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace transport {
+
+/*
+    * Префиксное дерево над фиксированным набором имён, уложенное в плоские массивы.
+    * Рёбра каждого узла лежат подряд в labels и targets, отсортированные по символу,
+    * границы хранятся в edge_offsets. Массивы не содержат указателей и хранятся в базе как есть
+    */
+class NameTrie {
+public:
+    static constexpr uint32_t NO_VALUE = UINT32_MAX;
+
+    struct Table {
+        std::vector<uint32_t> edge_offsets;
+        std::string labels;
+        std::vector<uint32_t> targets;
+        std::vector<uint32_t> values;
+    };
+
+    NameTrie() = default;
+    explicit NameTrie(std::vector<std::pair<std::string_view, uint32_t>> keys);
+    explicit NameTrie(Table table);
+
+    // Возвращает не более limit пар (значение, число правок), у которых некоторый префикс имени
+    // отличается от query не более чем на max_edits правок. Правки считаются по символам UTF-8,
+    // а не по байтам. Порядок: по числу правок, затем по имени
+    std::vector<std::pair<uint32_t, uint32_t>> Search(std::string_view query, uint32_t max_edits, size_t limit) const;
+
+    const Table& GetTable() const;
+    bool IsEmpty() const;
+
+private:
+    struct SearchState;
+
+    void SearchNode(uint32_t node, size_t depth, uint32_t best, SearchState& state) const;
+    void SearchSymbol(uint32_t node, size_t depth, uint32_t best, uint32_t symbol, size_t pending, SearchState& state) const;
+    void CollectSubtree(uint32_t node, uint32_t edits, SearchState& state) const;
+
+    Table table_;
+};
+
+} // namespace transport
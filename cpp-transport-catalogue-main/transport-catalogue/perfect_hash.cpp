@@ -0,0 +1,137 @@
+#include "perfect_hash.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+namespace transport {
+
+namespace {
+
+const uint32_t MAX_SEED = 1u << 22;
+
+uint64_t HashName(std::string_view name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const unsigned char c : name) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t Mix(uint64_t hash, uint64_t seed) {
+    hash ^= seed * 0x9E3779B97F4A7C15ull;
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+uint32_t GetFingerprint(uint64_t hash) {
+    return static_cast<uint32_t>(hash >> 32);
+}
+
+} // namespace
+
+PerfectHash::PerfectHash(const std::vector<std::pair<std::string_view, uint32_t>>& keys) {
+    if (keys.empty()) {
+        return;
+    }
+    size_t bucket_count = keys.size() / 4 + 1;
+    while (!TryBuild(keys, bucket_count)) {
+        bucket_count *= 2;
+        if (bucket_count > keys.size() * 8) {
+            throw std::logic_error("perfect hash can not be built: hash collision");
+        }
+    }
+}
+
+PerfectHash::PerfectHash(Table table)
+    : table_(std::move(table))
+{
+}
+
+std::optional<uint32_t> PerfectHash::Find(std::string_view key) const {
+    if (IsEmpty()) {
+        return std::nullopt;
+    }
+    const uint64_t hash = HashName(key);
+    const uint32_t seed = table_.seeds[Mix(hash, 0) % table_.seeds.size()];
+    const size_t slot = Mix(hash, seed) % table_.values.size();
+    if (table_.fingerprints[slot] != GetFingerprint(hash)) {
+        return std::nullopt;
+    }
+    return table_.values[slot];
+}
+
+const PerfectHash::Table& PerfectHash::GetTable() const {
+    return table_;
+}
+
+bool PerfectHash::IsEmpty() const {
+    return table_.values.empty();
+}
+
+bool PerfectHash::TryBuild(const std::vector<std::pair<std::string_view, uint32_t>>& keys, size_t bucket_count) {
+    const size_t table_size = keys.size();
+    std::vector<uint64_t> hashes(keys.size());
+    std::vector<std::vector<uint32_t>> buckets(bucket_count);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        hashes[i] = HashName(keys[i].first);
+        buckets[Mix(hashes[i], 0) % bucket_count].push_back(static_cast<uint32_t>(i));
+    }
+
+    // Сначала размещаются самые большие корзины, пока в таблице много свободных ячеек
+    std::vector<uint32_t> order(bucket_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&buckets](uint32_t lhs, uint32_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    Table table;
+    table.seeds.assign(bucket_count, 0);
+    table.values.assign(table_size, 0);
+    table.fingerprints.assign(table_size, 0);
+    std::vector<bool> occupied(table_size, false);
+    std::vector<size_t> slots;
+
+    for (const uint32_t bucket : order) {
+        const auto& bucket_keys = buckets[bucket];
+        if (bucket_keys.empty()) {
+            break;
+        }
+        uint32_t seed = 1;
+        for (; seed < MAX_SEED; ++seed) {
+            slots.clear();
+            bool fits = true;
+            for (const uint32_t key : bucket_keys) {
+                const size_t slot = Mix(hashes[key], seed) % table_size;
+                if (occupied[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    fits = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (fits) {
+                break;
+            }
+        }
+        if (seed == MAX_SEED) {
+            return false;
+        }
+
+        table.seeds[bucket] = seed;
+        for (size_t i = 0; i < bucket_keys.size(); ++i) {
+            occupied[slots[i]] = true;
+            table.values[slots[i]] = keys[bucket_keys[i]].second;
+            table.fingerprints[slots[i]] = GetFingerprint(hashes[bucket_keys[i]]);
+        }
+    }
+
+    table_ = std::move(table);
+    return true;
+}
+
+} // namespace transport
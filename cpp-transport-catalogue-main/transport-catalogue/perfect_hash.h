@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace transport {
+
+/*
+    * Минимальная совершенная хеш-функция над фиксированным набором имён (схема hash-and-displace).
+    * Ключи раскладываются по корзинам, для каждой корзины подбирается seed,
+    * при котором все её ключи попадают в свободные ячейки таблицы размером ровно с число ключей.
+    * В ячейке хранится значение и отпечаток хеша, отсекающий большинство незнакомых имён
+    * без сравнения строк. Таблица не зависит от адресов в памяти и может храниться в базе
+    */
+class PerfectHash {
+public:
+    struct Table {
+        std::vector<uint32_t> seeds;
+        std::vector<uint32_t> values;
+        std::vector<uint32_t> fingerprints;
+    };
+
+    PerfectHash() = default;
+    explicit PerfectHash(const std::vector<std::pair<std::string_view, uint32_t>>& keys);
+    explicit PerfectHash(Table table);
+
+    // Возвращает значение-кандидат: совпадение имени вызывающий проверяет сам одним сравнением
+    std::optional<uint32_t> Find(std::string_view key) const;
+
+    const Table& GetTable() const;
+    bool IsEmpty() const;
+
+private:
+    bool TryBuild(const std::vector<std::pair<std::string_view, uint32_t>>& keys, size_t bucket_count);
+
+    Table table_;
+};
+
+} // namespace transport
@@ -1,9 +1,6 @@
 #pragma once
 
 #include <iterator>
-#include <string_view>
-#include <unordered_map>
-#include <unordered_set>
 
 namespace ranges {
 
@@ -1,12 +1,28 @@
 #include "request_handler.h"
 
 std::optional<transport::BusStat> RequestHandler::GetBusStatata(const std::string_view bus_number) const {
-    TransportCatalogue transportCatalogue(catalogue_);
-    return transportCatalogue.GetBusStat(bus_number);
+    return catalogue_.GetBusStat(bus_number);
 }
 
-const std::set<std::string> RequestHandler::GetBusesByStop(std::string_view stop_name) const {
-    return catalogue_.FindStop(stop_name)->buses_by_stop;
+std::optional<transport::RouteSegmentStat> RequestHandler::GetRouteSegmentStat(std::string_view bus_number, std::string_view stop_from, std::string_view stop_to) const {
+    return catalogue_.GetRouteSegmentStat(bus_number, stop_from, stop_to);
+}
+
+const std::vector<std::string_view> RequestHandler::GetBusesByStop(std::string_view stop_name) const {
+    return catalogue_.GetBusesByStop(catalogue_.FindStop(stop_name));
+}
+
+const std::optional<std::vector<std::string_view>> RequestHandler::GetCommonBuses(const std::vector<std::string_view>& stop_names) const {
+    std::vector<const transport::Stop*> stops;
+    stops.reserve(stop_names.size());
+    for (const auto stop_name : stop_names) {
+        const transport::Stop* stop = catalogue_.FindStop(stop_name);
+        if (!stop) {
+            return std::nullopt;
+        }
+        stops.push_back(stop);
+    }
+    return catalogue_.GetCommonBuses(stops);
 }
 
 bool RequestHandler::IsBusNumber(const std::string_view bus_number) const {
@@ -21,10 +37,49 @@ const std::optional<graph::Router<double>::RouteInfo> RequestHandler::GetOptimal
     return router_.FindRoute(stop_from, stop_to);
 }
 
+const std::optional<transport::WalkingRouteInfo> RequestHandler::GetOptimalRoute(geo::Coordinates from, geo::Coordinates to, double walking_speed) const {
+    const double meters_per_minute = walking_speed * (100.0 / 6.0);
+    auto walk_to_stops = [this, meters_per_minute](geo::Coordinates point) {
+        std::vector<std::pair<std::string_view, double>> result;
+        for (const auto& [stop, distance] : catalogue_.FindNearestStops(point, WALK_SEARCH_RADIUS, WALK_SEARCH_STOPS)) {
+            result.emplace_back(stop->name, distance / meters_per_minute);
+        }
+        return result;
+    };
+
+    std::optional<transport::WalkingRouteInfo> result;
+    const auto origins = walk_to_stops(from);
+    const auto destinations = walk_to_stops(to);
+    if (!origins.empty() && !destinations.empty()) {
+        result = router_.FindRoute(origins, destinations);
+    }
+
+    const double direct_distance = geo::ComputeDistance(from, to);
+    if (direct_distance <= WALK_SEARCH_RADIUS) {
+        const double direct_time = direct_distance / meters_per_minute;
+        if (!result || direct_time <= result->total_time) {
+            result = transport::WalkingRouteInfo{ direct_time, {}, 0.0, {}, {}, 0.0 };
+        }
+    }
+    return result;
+}
+
 const graph::DirectedWeightedGraph<double>& RequestHandler::GetRouterGraph() const {
     return router_.GetGraph();
 }
 
-svg::Document RequestHandler::RenderMap() const {
-    return renderer_.GetSVG(catalogue_.GetSortedAllBuses());
+std::vector<std::pair<const transport::Stop*, double>> RequestHandler::GetNearestStops(geo::Coordinates center, double radius, size_t limit) const {
+    return catalogue_.FindNearestStops(center, radius, limit);
+}
+
+std::vector<std::pair<const transport::Stop*, uint32_t>> RequestHandler::SearchStops(std::string_view query, uint32_t max_edits, size_t limit) const {
+    return catalogue_.SearchStops(query, std::min(max_edits, MAX_SEARCH_EDITS), std::min(limit, MAX_SEARCH_STOPS));
+}
+
+std::string RequestHandler::RenderMap(const renderer::MapView& view) const {
+    return renderer_.RenderMap(snapshot_->map_index, view);
+}
+
+std::string_view RequestHandler::GetMapJson() const {
+    return snapshot_->map_json;
 }
\ No newline at end of file
@@ -4,30 +4,48 @@
 #include "transport_catalogue.h"
 #include "map_renderer.h"
 #include "transport_router.h"
+#include "snapshot.h"
 
 #include <sstream>
 #include <optional>
 
 class RequestHandler {
 public:
-    RequestHandler(const transport::TransportCatalogue& catalogue, const renderer::MapRenderer& renderer, const transport::Router& router)
-        : catalogue_(catalogue)
-        , renderer_(renderer)
-        , router_(router)
+    // Радиус и число ближайших остановок, до которых ищется пеший путь от произвольной точки
+    static constexpr double WALK_SEARCH_RADIUS = 1500.0;
+    static constexpr size_t WALK_SEARCH_STOPS = 5;
+    static constexpr uint32_t MAX_SEARCH_EDITS = 2;
+    static constexpr size_t MAX_SEARCH_STOPS = 100;
+
+    // Обработчик удерживает снимок до конца своей работы, даже если тем временем опубликован новый
+    explicit RequestHandler(transport::SnapshotPtr snapshot)
+        : snapshot_(std::move(snapshot))
+        , catalogue_(snapshot_->catalogue)
+        , renderer_(snapshot_->renderer)
+        , router_(snapshot_->router)
     {
     }
 
     std::optional<transport::BusStat> GetBusStatata(const std::string_view bus_number) const;
+    std::optional<transport::RouteSegmentStat> GetRouteSegmentStat(std::string_view bus_number, std::string_view stop_from, std::string_view stop_to) const;
 
-    const std::set<std::string> GetBusesByStop(std::string_view stop_name) const;
+    const std::vector<std::string_view> GetBusesByStop(std::string_view stop_name) const;
+    const std::optional<std::vector<std::string_view>> GetCommonBuses(const std::vector<std::string_view>& stop_names) const;
     bool IsBusNumber(const std::string_view bus_number) const;
     bool IsStopName(const std::string_view stop_name) const;
     const std::optional<graph::Router<double>::RouteInfo> GetOptimalRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+    const std::optional<transport::WalkingRouteInfo> GetOptimalRoute(geo::Coordinates from, geo::Coordinates to, double walking_speed) const;
     const graph::DirectedWeightedGraph<double>& GetRouterGraph() const;
+    std::vector<std::pair<const transport::Stop*, double>> GetNearestStops(geo::Coordinates center, double radius, size_t limit) const;
+    std::vector<std::pair<const transport::Stop*, uint32_t>> SearchStops(std::string_view query, uint32_t max_edits, size_t limit) const;
 
-    svg::Document RenderMap() const;
+    // Окно карты, отрисованное по запросу
+    std::string RenderMap(const renderer::MapView& view) const;
+    // Карта из базы, уже закодированная строкой JSON
+    std::string_view GetMapJson() const;
 
 private:
+    transport::SnapshotPtr snapshot_;
     const transport::TransportCatalogue& catalogue_;
     const renderer::MapRenderer& renderer_;
     const transport::Router& router_;
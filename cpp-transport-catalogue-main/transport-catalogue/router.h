@@ -6,7 +6,9 @@
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <functional>
 #include <optional>
+#include <queue>
 #include <stdexcept>
 #include <unordered_map>
 #include <utility>
@@ -27,8 +29,20 @@ public:
         std::vector<EdgeId> edges;
     };
 
+    struct MultiRouteInfo {
+        Weight weight;
+        size_t source_index;
+        size_t target_index;
+        std::vector<EdgeId> edges;
+    };
+
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // Один поиск Дейкстры сразу из нескольких источников в несколько целей.
+    // Каждый источник и каждая цель несут начальный вес (например, время пешком до остановки)
+    std::optional<MultiRouteInfo> BuildRoute(const std::vector<std::pair<VertexId, Weight>>& sources,
+        const std::vector<std::pair<VertexId, Weight>>& targets) const;
+
 private:
     struct RouteInternalData {
         Weight weight;
@@ -114,4 +128,81 @@ std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(Ver
     return RouteInfo{ weight, std::move(edges) };
 }
 
+template <typename Weight>
+std::optional<typename Router<Weight>::MultiRouteInfo> Router<Weight>::BuildRoute(
+    const std::vector<std::pair<VertexId, Weight>>& sources,
+    const std::vector<std::pair<VertexId, Weight>>& targets) const {
+    struct VertexState {
+        std::optional<Weight> weight;
+        std::optional<EdgeId> prev_edge;
+        size_t source_index = 0;
+    };
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    const size_t vertex_count = graph_.GetVertexCount();
+    std::vector<VertexState> states(vertex_count);
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        const auto& [vertex, weight] = sources[i];
+        auto& state = states.at(vertex);
+        if (!state.weight || weight < *state.weight) {
+            state = { weight, std::nullopt, i };
+            queue.push({ weight, vertex });
+        }
+    }
+
+    std::unordered_map<VertexId, size_t> target_by_vertex;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        auto [it, inserted] = target_by_vertex.emplace(targets[i].first, i);
+        if (!inserted && targets[i].second < targets[it->second].second) {
+            it->second = i;
+        }
+    }
+
+    std::optional<Weight> best_weight;
+    VertexId best_vertex = 0;
+    size_t best_target = 0;
+    while (!queue.empty()) {
+        const auto [weight, vertex] = queue.top();
+        queue.pop();
+        if (best_weight && !(weight < *best_weight)) {
+            break;
+        }
+        if (*states[vertex].weight < weight) {
+            continue;
+        }
+        if (const auto it = target_by_vertex.find(vertex); it != target_by_vertex.end()) {
+            const Weight candidate_weight = weight + targets[it->second].second;
+            if (!best_weight || candidate_weight < *best_weight) {
+                best_weight = candidate_weight;
+                best_vertex = vertex;
+                best_target = it->second;
+            }
+        }
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            auto& state = states[edge.to];
+            if (!state.weight || candidate_weight < *state.weight) {
+                state = { candidate_weight, edge_id, states[vertex].source_index };
+                queue.push({ candidate_weight, edge.to });
+            }
+        }
+    }
+
+    if (!best_weight) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = states[best_vertex].prev_edge;
+        edge_id;
+        edge_id = states[graph_.GetEdge(*edge_id).from].prev_edge)
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return MultiRouteInfo{ *best_weight, states[best_vertex].source_index, best_target, std::move(edges) };
+}
+
 }  // namespace graph
\ No newline at end of file
@@ -1,6 +1,10 @@
 #include "serialization.h"
 
+#include <algorithm>
 #include <fstream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
 
 namespace serialization {
 
@@ -10,48 +14,84 @@ void Serialize(const transport::TransportCatalogue& db, const renderer::MapRende
     SerializeStops(db, proto_db);
     SerializeStopDistances(db, proto_db);
     SerializeBuses(db, proto_db);
+    SerializeStopIndex(db, proto_db);
+    SerializeBusIndex(db, proto_db);
+    SerializeNameIndex(db, proto_db);
+    SerializeSearchIndex(db, proto_db);
     SerializeRenderSettings(renderer, proto_db);
+    SerializeMap(db, renderer, proto_db);
     SerializeRouter(router, proto_db);
     
     proto_db.SerializeToOstream(&out);
 }
 
-std::tuple<transport::TransportCatalogue, renderer::MapRenderer, transport::Router, graph::DirectedWeightedGraph<double>, std::map<std::string, graph::VertexId>> Deserialize(std::istream& input) {
+std::tuple<transport::TransportCatalogue, renderer::MapRenderer, transport::Router, graph::DirectedWeightedGraph<double>, std::map<std::string_view, graph::VertexId>, std::string, std::vector<renderer::SimplifiedRoute>> Deserialize(std::istream& input) {
     proto_transport::Catalogue proto_db;
-    proto_db.ParseFromIstream(&input);
-
-    transport::TransportCatalogue db;
+    if (!proto_db.ParseFromIstream(&input)) {
+        throw std::runtime_error("Failed to parse the transport base");
+    }
 
-    DeserializeStops(db, proto_db);
-    DeserializeStopDistances(db, proto_db);
-    DeserializeBuses(db, proto_db);
+    transport::CatalogueBuilder builder(proto_db.stops_size(), proto_db.buses_size(), proto_db.stop_distances_size());
+    DeserializeStops(builder, proto_db);
+    DeserializeStopDistances(builder, proto_db);
+    DeserializeBuses(builder, proto_db);
+    transport::TransportCatalogue db = builder.Build();
+
+    db.BuildSortedIndex();
+    DeserializeBusIndex(db, proto_db);
+    DeserializeStopIndex(db, proto_db);
+    DeserializeNameIndex(db, proto_db);
+    DeserializeSearchIndex(db, proto_db);
     
     renderer::RenderSettings render_settings;
     renderer::MapRenderer renderer = DeserializeRenderSettings(render_settings, proto_db);
     transport::Router router = DeserializeRouterSettings(proto_db);
     
-    return { std::move(db), std::move(renderer), std::move(router), DeserializeGraph(proto_db), DeserializeStopIds(proto_db) };
+    // Имена в графе и в stop_ids указывают в хранилище имён каталога, поэтому они строятся до его перемещения
+    auto graph = DeserializeGraph(db, proto_db);
+    auto stop_ids = DeserializeStopIds(db, proto_db);
+
+    return { std::move(db), std::move(renderer), std::move(router), std::move(graph), std::move(stop_ids), std::move(*proto_db.mutable_rendered_map()),
+        DeserializeSimplifiedRoutes(proto_db) };
+}
+
+transport::SnapshotPtr LoadSnapshot(std::istream& input) {
+    auto [db, renderer, router, graph, stop_ids, rendered_map, simplified_routes] = Deserialize(input);
+    // Граф передаётся маршрутизатору уже внутри снимка: поиск маршрутов ссылается на граф по адресу
+    auto snapshot = std::make_shared<transport::Snapshot>(std::move(db), std::move(renderer), std::move(router));
+    snapshot->router.SetGraph(std::move(graph), std::move(stop_ids));
+    snapshot->map_index.SetSimplifiedRoutes(std::move(simplified_routes));
+    // В базах, построенных до появления кэша, карта отрисовывается один раз при загрузке
+    if (rendered_map.empty()) {
+        rendered_map = snapshot->renderer.RenderMap(snapshot->map_index, renderer::MapView{});
+    }
+    snapshot->SetMap(rendered_map);
+    return snapshot;
 }
 
 void SerializeStops(const transport::TransportCatalogue& db, proto_transport::Catalogue& proto_db) {
-    const auto all_stops = db.GetSortedAllStops();
-    for (const auto& stop : all_stops) {
+    // Остановки сохраняются в порядке добавления: индексы каталога ссылаются на их номера
+    for (const auto& stop : db.GetAllStops()) {
         proto_transport::Stop proto_stop;
-        proto_stop.set_name(stop.second->name);
-        proto_stop.mutable_coordinates()->set_lat(stop.second->coordinates.lat);
-        proto_stop.mutable_coordinates()->set_lng(stop.second->coordinates.lng);
-        for (const auto& bus : stop.second->buses_by_stop) {
-            proto_stop.add_buses_by_stop(bus);
-        }
+        proto_stop.set_name(std::string(stop.name));
+        proto_stop.mutable_coordinates()->set_lat(stop.coordinates.lat);
+        proto_stop.mutable_coordinates()->set_lng(stop.coordinates.lng);
         *proto_db.add_stops() = std::move(proto_stop);
     }
 }
 
 void SerializeStopDistances(const transport::TransportCatalogue& db, proto_transport::Catalogue& proto_db) {
-    for (const auto& [stop_pair, distance] : db.GetStopDistances()) {
+    // Порядок обхода хеш-таблицы зависит от адресов остановок, поэтому для одинаковой базы
+    // при одинаковом входе расстояния записываются упорядоченными по именам
+    const auto stop_distances = db.GetStopDistances();
+    std::vector<std::pair<std::pair<const transport::Stop*, const transport::Stop*>, int>> sorted_distances(stop_distances.begin(), stop_distances.end());
+    std::sort(sorted_distances.begin(), sorted_distances.end(), [](const auto& lhs, const auto& rhs) {
+        return std::tie(lhs.first.first->name, lhs.first.second->name) < std::tie(rhs.first.first->name, rhs.first.second->name);
+    });
+    for (const auto& [stop_pair, distance] : sorted_distances) {
         proto_transport::StopDistanses proto_stop_distances;
-        proto_stop_distances.set_from(stop_pair.first->name);
-        proto_stop_distances.set_to(stop_pair.second->name);
+        proto_stop_distances.set_from(std::string(stop_pair.first->name));
+        proto_stop_distances.set_to(std::string(stop_pair.second->name));
         proto_stop_distances.set_distance(distance);
 
         *proto_db.add_stop_distances() = std::move(proto_stop_distances);
@@ -59,29 +99,92 @@ void SerializeStopDistances(const transport::TransportCatalogue& db, proto_trans
 }
     
 void SerializeBuses(const transport::TransportCatalogue& db, proto_transport::Catalogue& proto_db) {
-    // Получаем отсортированный список всех автобусов
-    const auto all_buses = db.GetSortedAllBuses();
-
-    // Перебираем каждый автобус
-    for (const auto& bus : all_buses) {
+    // Перебираем каждый автобус в порядке добавления, как и остановки
+    for (const auto& bus : db.GetAllBuses()) {
         // Создаем объект proto_bus для сериализации
         proto_transport::Bus proto_bus;
-        proto_bus.set_number(bus.second->number);
+        proto_bus.set_number(std::string(bus.number));
 
         // Добавляем каждую остановку автобуса в список
-        for (const auto* stop : bus.second->stops) {
-            *proto_bus.mutable_stops()->Add() = stop->name;
+        for (const auto* stop : bus.stops) {
+            *proto_bus.mutable_stops()->Add() = std::string(stop->name);
         }
 
         // Устанавливаем флаг, показывающий является ли маршрут кольцевым
-        proto_bus.set_is_circle(bus.second->is_circle);
+        proto_bus.set_is_circle(bus.is_circle);
 
         // Добавляем сериализованный автобус в общий список
         *proto_db.add_buses() = std::move(proto_bus);
     }
 }
 
-// Функция для сериализации настроек отображения карты
+// Функция для сериализации сетки пространственного индекса остановок
+void SerializeStopIndex(const transport::TransportCatalogue& db, proto_transport::Catalogue& proto_db) {
+    const auto& grid = db.GetStopIndex().GetGrid();
+    proto_transport::StopIndex proto_stop_index;
+    proto_stop_index.set_min_lat(grid.min_lat);
+    proto_stop_index.set_min_lng(grid.min_lng);
+    proto_stop_index.set_cell_size(grid.cell_size);
+    proto_stop_index.set_rows(grid.rows);
+    proto_stop_index.set_cols(grid.cols);
+    *proto_stop_index.mutable_cell_offsets() = { grid.cell_offsets.begin(), grid.cell_offsets.end() };
+    *proto_stop_index.mutable_stop_ids() = { grid.items.begin(), grid.items.end() };
+    *proto_db.mutable_stop_index() = std::move(proto_stop_index);
+}
+
+// Функция для сериализации списков маршрутов по остановкам: смещения и номера маршрутов подряд
+void SerializeBusIndex(const transport::TransportCatalogue& db, proto_transport::Catalogue& proto_db) {
+    proto_transport::BusIndex proto_bus_index;
+    proto_bus_index.add_offsets(0);
+    for (const auto& stop : db.GetAllStops()) {
+        for (const uint32_t bus_id : stop.bus_ids) {
+            proto_bus_index.add_bus_ids(bus_id);
+        }
+        proto_bus_index.add_offsets(proto_bus_index.bus_ids_size());
+    }
+    *proto_db.mutable_bus_index() = std::move(proto_bus_index);
+}
+
+// Функция для сериализации совершенных хеш-функций имён остановок и маршрутов
+void SerializeNameIndex(const transport::TransportCatalogue& db, proto_transport::Catalogue& proto_db) {
+    *proto_db.mutable_stop_names() = SerializePerfectHash(db.GetStopNameIndex());
+    *proto_db.mutable_bus_names() = SerializePerfectHash(db.GetBusNameIndex());
+}
+
+proto_transport::NameIndex SerializePerfectHash(const transport::PerfectHash& hash) {
+    const auto& table = hash.GetTable();
+    proto_transport::NameIndex proto_hash;
+    *proto_hash.mutable_seeds() = { table.seeds.begin(), table.seeds.end() };
+    *proto_hash.mutable_values() = { table.values.begin(), table.values.end() };
+    *proto_hash.mutable_fingerprints() = { table.fingerprints.begin(), table.fingerprints.end() };
+    return proto_hash;
+}
+
+// Функция для сериализации префиксного дерева имён остановок: массивы узлов и рёбер без перестройки
+void SerializeSearchIndex(const transport::TransportCatalogue& db, proto_transport::Catalogue& proto_db) {
+    const auto& table = db.GetSearchIndex().GetTable();
+    proto_transport::NameTrie proto_trie;
+    *proto_trie.mutable_edge_offsets() = { table.edge_offsets.begin(), table.edge_offsets.end() };
+    proto_trie.set_labels(table.labels);
+    *proto_trie.mutable_targets() = { table.targets.begin(), table.targets.end() };
+    *proto_trie.mutable_values() = { table.values.begin(), table.values.end() };
+    *proto_db.mutable_stop_search() = std::move(proto_trie);
+}
+
+// Функция для сериализации карты: упрощённые линии маршрутов и отрисованная по ним полная карта
+void SerializeMap(const transport::TransportCatalogue& db, const renderer::MapRenderer& renderer, proto_transport::Catalogue& proto_db) {
+    renderer::MapIndex index(db.GetSortedAllBuses(), db.GetSortedAllStops());
+    index.SetSimplifiedRoutes(renderer.SimplifyRoutes(index));
+    for (const auto& route : index.GetSimplifiedRoutes()) {
+        proto_map::SimplifiedRoute proto_route;
+        for (const auto& level : route.levels) {
+            *proto_route.add_levels()->mutable_stop_indices() = { level.begin(), level.end() };
+        }
+        *proto_db.add_simplified_routes() = std::move(proto_route);
+    }
+    proto_db.set_rendered_map(renderer.RenderMap(index, renderer::MapView{}));
+}
+
 void SerializeRenderSettings(const renderer::MapRenderer& renderer, proto_transport::Catalogue& proto_db) {
     // Получаем объект с настройками отображения
     const auto render_settings = renderer.GetRenderSettings();
@@ -106,6 +209,8 @@ void SerializeRenderSettings(const renderer::MapRenderer& renderer, proto_transp
     for (const auto& color : render_settings.color_palette) {
         *proto_render_settings.add_color_palette() = SerializeColor(color);
     }
+    proto_render_settings.set_coordinate_precision(render_settings.coordinate_precision);
+    proto_render_settings.set_simplify_tolerance(render_settings.simplify_tolerance);
 
     // Добавляем сериализованные настройки отображения в общий список
     *proto_db.mutable_render_settings() = std::move(proto_render_settings);
@@ -167,15 +272,15 @@ void SerializeRouter(const transport::Router& router, proto_transport::Catalogue
     proto_transport::Router proto_router;
 
     // Сериализуем настройки маршрутизатора
-    *proto_router.mutable_router_settings() = SerializeRouterSettings(router, proto_db);
+    *proto_router.mutable_router_settings() = SerializeRouterSettings(router);
 
     // Сериализуем граф маршрутизатора
-    *proto_router.mutable_graph() = SerializeGraph(router, proto_db);
+    *proto_router.mutable_graph() = SerializeGraph(router);
 
     // Добавляем каждый идентификатор остановки в список
     for (const auto& [name, id] : router.GetStopIds()) {
         proto_transport::StopId proto_stop_id;
-        proto_stop_id.set_name(name);
+        proto_stop_id.set_name(std::string(name));
         proto_stop_id.set_id(id);
         *proto_router.add_stop_ids() = std::move(proto_stop_id);
     }
@@ -185,7 +290,7 @@ void SerializeRouter(const transport::Router& router, proto_transport::Catalogue
 }
 
 // Функция для сериализации настроек маршрутизатора
-proto_transport::RouterSettings SerializeRouterSettings(const transport::Router& router, proto_transport::Catalogue& proto_db) {
+proto_transport::RouterSettings SerializeRouterSettings(const transport::Router& router) {
     proto_transport::RouterSettings proto_router_settings;
     proto_router_settings.set_bus_wait_time(router.GetBusWaitTime());
     proto_router_settings.set_bus_velocity(router.GetBusVelocity());
@@ -193,14 +298,14 @@ proto_transport::RouterSettings SerializeRouterSettings(const transport::Router&
 }
 
 // Функция для сериализации графа
-proto_graph::Graph SerializeGraph(const transport::Router& router, proto_transport::Catalogue& proto_db) {
+proto_graph::Graph SerializeGraph(const transport::Router& router) {
     proto_graph::Graph proto_graph;
 
     // Добавляем каждое ребро графа в список
-    for (int i = 0; i < router.GetGraph().GetEdgeCount(); ++i) {
+    for (size_t i = 0; i < router.GetGraph().GetEdgeCount(); ++i) {
         const graph::Edge edge = router.GetGraph().GetEdge(i);
         proto_graph::Edge proto_edge;
-        proto_edge.set_name(edge.name);
+        proto_edge.set_name(std::string(edge.name));
         proto_edge.set_quality(edge.quality);
         proto_edge.set_from(edge.from);
         proto_edge.set_to(edge.to);
@@ -209,7 +314,7 @@ proto_graph::Graph SerializeGraph(const transport::Router& router, proto_transpo
     }
 
     // Добавляем каждую вершину графа в список
-    for (int i = 0; i < router.GetGraph().GetVertexCount(); ++i) {
+    for (size_t i = 0; i < router.GetGraph().GetVertexCount(); ++i) {
         proto_graph::Vertex proto_vertex;
 
         // Добавляем каждый идентификатор ребра, инцидентного данной вершине
@@ -223,31 +328,90 @@ proto_graph::Graph SerializeGraph(const transport::Router& router, proto_transpo
     return proto_graph;
 }
 
-void DeserializeStops(transport::TransportCatalogue& db, const proto_transport::Catalogue& proto_db) {
+void DeserializeStops(transport::CatalogueBuilder& builder, const proto_transport::Catalogue& proto_db) {
     for (int i = 0; i < proto_db.stops_size(); ++i) {
         const proto_transport::Stop& proto_stop = proto_db.stops(i);
-        db.AddStop(proto_stop.name(), { proto_stop.coordinates().lat(), proto_stop.coordinates().lng() });
+        builder.AddStop(proto_stop.name(), { proto_stop.coordinates().lat(), proto_stop.coordinates().lng() });
     }
 }
 
-void DeserializeStopDistances(transport::TransportCatalogue& db, const proto_transport::Catalogue& proto_db) {
+void DeserializeStopDistances(transport::CatalogueBuilder& builder, const proto_transport::Catalogue& proto_db) {
     for (int i = 0; i < proto_db.stop_distances_size(); ++i) {
         const proto_transport::StopDistanses& proto_stop_distances = proto_db.stop_distances(i);
-        const transport::Stop* from = db.FindStop(proto_stop_distances.from());
-        const transport::Stop* to = db.FindStop(proto_stop_distances.to());
-        db.SetDistance(from, to, proto_stop_distances.distance());
+        builder.AddDistance(proto_stop_distances.from(), proto_stop_distances.to(), proto_stop_distances.distance());
     }
 }
     
-void DeserializeBuses(transport::TransportCatalogue& db, const proto_transport::Catalogue& proto_db) {
+void DeserializeBuses(transport::CatalogueBuilder& builder, const proto_transport::Catalogue& proto_db) {
+    std::vector<std::string_view> stops;
     for (int i = 0; i < proto_db.buses_size(); ++i) {
         const proto_transport::Bus& proto_bus = proto_db.buses(i);
-        std::vector<const transport::Stop*> stops(proto_bus.stops_size());
-        for (int j = 0; j < stops.size(); ++j) {
-            stops[j] = db.FindStop(proto_bus.stops(j));
-        }
-        db.AddRoute(proto_bus.number(), stops, proto_bus.is_circle());
+        stops.assign(proto_bus.stops().begin(), proto_bus.stops().end());
+        builder.AddBus(proto_bus.number(), stops, proto_bus.is_circle());
+    }
+}
+
+void DeserializeStopIndex(transport::TransportCatalogue& db, const proto_transport::Catalogue& proto_db) {
+    if (!proto_db.has_stop_index()) {
+        db.BuildStopIndex();
+        return;
+    }
+    const proto_transport::StopIndex& proto_stop_index = proto_db.stop_index();
+    geo::SpatialIndex::Grid grid;
+    grid.min_lat = proto_stop_index.min_lat();
+    grid.min_lng = proto_stop_index.min_lng();
+    grid.cell_size = proto_stop_index.cell_size();
+    grid.rows = proto_stop_index.rows();
+    grid.cols = proto_stop_index.cols();
+    grid.cell_offsets = { proto_stop_index.cell_offsets().begin(), proto_stop_index.cell_offsets().end() };
+    grid.items = { proto_stop_index.stop_ids().begin(), proto_stop_index.stop_ids().end() };
+    db.SetStopIndex(std::move(grid));
+}
+
+void DeserializeBusIndex(transport::TransportCatalogue& db, const proto_transport::Catalogue& proto_db) {
+    if (!proto_db.has_bus_index()) {
+        db.BuildBusIndex();
+        return;
+    }
+    const proto_transport::BusIndex& proto_bus_index = proto_db.bus_index();
+    std::vector<std::vector<uint32_t>> bus_ids_by_stop(proto_bus_index.offsets_size() > 0 ? proto_bus_index.offsets_size() - 1 : 0);
+    for (size_t i = 0; i < bus_ids_by_stop.size(); ++i) {
+        bus_ids_by_stop[i] = {
+            proto_bus_index.bus_ids().begin() + proto_bus_index.offsets(i),
+            proto_bus_index.bus_ids().begin() + proto_bus_index.offsets(i + 1)
+        };
     }
+    db.SetBusIndex(std::move(bus_ids_by_stop));
+}
+
+void DeserializeNameIndex(transport::TransportCatalogue& db, const proto_transport::Catalogue& proto_db) {
+    if (!proto_db.has_stop_names() || !proto_db.has_bus_names()) {
+        db.BuildNameIndex();
+        return;
+    }
+    db.SetNameIndex(DeserializePerfectHash(proto_db.stop_names()), DeserializePerfectHash(proto_db.bus_names()));
+}
+
+transport::PerfectHash DeserializePerfectHash(const proto_transport::NameIndex& proto_hash) {
+    transport::PerfectHash::Table table;
+    table.seeds = { proto_hash.seeds().begin(), proto_hash.seeds().end() };
+    table.values = { proto_hash.values().begin(), proto_hash.values().end() };
+    table.fingerprints = { proto_hash.fingerprints().begin(), proto_hash.fingerprints().end() };
+    return transport::PerfectHash(std::move(table));
+}
+
+void DeserializeSearchIndex(transport::TransportCatalogue& db, const proto_transport::Catalogue& proto_db) {
+    if (!proto_db.has_stop_search()) {
+        db.BuildSearchIndex();
+        return;
+    }
+    const proto_transport::NameTrie& proto_trie = proto_db.stop_search();
+    transport::NameTrie::Table table;
+    table.edge_offsets = { proto_trie.edge_offsets().begin(), proto_trie.edge_offsets().end() };
+    table.labels = proto_trie.labels();
+    table.targets = { proto_trie.targets().begin(), proto_trie.targets().end() };
+    table.values = { proto_trie.values().begin(), proto_trie.values().end() };
+    db.SetSearchIndex(transport::NameTrie(std::move(table)));
 }
 
 renderer::MapRenderer DeserializeRenderSettings(renderer::RenderSettings& render_settings, const proto_transport::Catalogue& proto_db) {
@@ -266,9 +430,26 @@ renderer::MapRenderer DeserializeRenderSettings(renderer::RenderSettings& render
     for (int i = 0; i < proto_render_settings.color_palette_size(); ++i) {
         render_settings.color_palette.push_back(DeserializeColor(proto_render_settings.color_palette(i)));
     }
+    if (proto_render_settings.coordinate_precision() > 0) {
+        render_settings.coordinate_precision = proto_render_settings.coordinate_precision();
+    }
+    render_settings.simplify_tolerance = proto_render_settings.simplify_tolerance();
     return render_settings;
 }
 
+std::vector<renderer::SimplifiedRoute> DeserializeSimplifiedRoutes(const proto_transport::Catalogue& proto_db) {
+    std::vector<renderer::SimplifiedRoute> routes;
+    routes.reserve(proto_db.simplified_routes_size());
+    for (const auto& proto_route : proto_db.simplified_routes()) {
+        renderer::SimplifiedRoute route;
+        for (const auto& proto_level : proto_route.levels()) {
+            route.levels.emplace_back(proto_level.stop_indices().begin(), proto_level.stop_indices().end());
+        }
+        routes.push_back(std::move(route));
+    }
+    return routes;
+}
+
 svg::Point DeserializePoint(const proto_map::Point& proto_point) {
     return { proto_point.x(), proto_point.y() };
 }
@@ -300,14 +481,14 @@ transport::Router DeserializeRouterSettings(const proto_transport::Catalogue& pr
     };
 }
 
-graph::DirectedWeightedGraph<double> DeserializeGraph(const proto_transport::Catalogue& proto_db) {
+graph::DirectedWeightedGraph<double> DeserializeGraph(transport::TransportCatalogue& db, const proto_transport::Catalogue& proto_db) {
     const proto_graph::Graph& proto_graph = proto_db.router().graph();
     std::vector<graph::Edge<double>> edges(proto_graph.edge_size());
     std::vector<std::vector<graph::EdgeId>> incidence_lists(proto_graph.vertex_size());
     for (int i = 0; i < proto_graph.edge_size(); ++i) {
         const auto& proto_edge = proto_graph.edge(i);
         edges[i] = {
-            proto_edge.name(),
+            db.InternName(proto_edge.name()),
             static_cast<size_t>(proto_edge.quality()),
             static_cast<size_t>(proto_edge.from()),
             static_cast<size_t>(proto_edge.to()),
@@ -324,10 +505,10 @@ graph::DirectedWeightedGraph<double> DeserializeGraph(const proto_transport::Cat
     return graph::DirectedWeightedGraph<double>(edges, incidence_lists);
 }
 
-std::map<std::string, graph::VertexId> DeserializeStopIds(const proto_transport::Catalogue& proto_db) {
-    std::map<std::string, graph::VertexId> stop_ids;
+std::map<std::string_view, graph::VertexId> DeserializeStopIds(transport::TransportCatalogue& db, const proto_transport::Catalogue& proto_db) {
+    std::map<std::string_view, graph::VertexId> stop_ids;
     for (const auto& proto_stop_id : proto_db.router().stop_ids()) {
-        stop_ids[proto_stop_id.name()] = proto_stop_id.id();
+        stop_ids[db.InternName(proto_stop_id.name())] = proto_stop_id.id();
     }
     return stop_ids;
 }
@@ -0,0 +1,27 @@
+#include "snapshot.h"
+#include "json_writer.h"
+
+#include <sstream>
+
+namespace transport {
+
+void Snapshot::SetMap(std::string_view svg) {
+    std::ostringstream strm;
+    json::Writer(strm).Value(svg);
+    map_json = strm.str();
+}
+
+SnapshotHolder::SnapshotHolder(SnapshotPtr snapshot)
+    : current_(std::move(snapshot))
+{
+}
+
+SnapshotPtr SnapshotHolder::Get() const {
+    return std::atomic_load(&current_);
+}
+
+void SnapshotHolder::Publish(SnapshotPtr snapshot) {
+    std::atomic_store(&current_, std::move(snapshot));
+}
+
+} // namespace transport
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "map_renderer.h"
+#include "transport_router.h"
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace transport {
+
+/*
+    * Неизменяемый набор данных, по которому обслуживаются запросы.
+    * Снимок собирается целиком до публикации и дальше только читается,
+    * поэтому потоки запросов работают с ним без блокировок
+    */
+struct Snapshot {
+    Snapshot(TransportCatalogue catalogue, renderer::MapRenderer renderer, Router router)
+        : catalogue(std::move(catalogue))
+        , renderer(std::move(renderer))
+        , router(std::move(router))
+        , map_index(this->catalogue.GetSortedAllBuses(), this->catalogue.GetSortedAllStops())
+    {
+    }
+
+    // Сохраняет отрисованную карту сразу закодированной строкой JSON, чтобы отдавать её без обработки
+    void SetMap(std::string_view svg);
+
+    TransportCatalogue catalogue;
+    renderer::MapRenderer renderer;
+    Router router;
+    // Строится по уже перемещённому каталогу и ссылается на его остановки и маршруты
+    renderer::MapIndex map_index;
+    std::string map_json;
+};
+
+using SnapshotPtr = std::shared_ptr<const Snapshot>;
+
+/*
+    * Точка публикации текущего снимка.
+    * Get захватывает владение снимком, поэтому начатые запросы дорабатывают на старых данных,
+    * а Publish атомарно подменяет снимок для всех последующих запросов
+    */
+class SnapshotHolder {
+public:
+    SnapshotHolder() = default;
+    explicit SnapshotHolder(SnapshotPtr snapshot);
+
+    SnapshotPtr Get() const;
+    void Publish(SnapshotPtr snapshot);
+
+private:
+    SnapshotPtr current_;
+};
+
+} // namespace transport
@@ -0,0 +1,241 @@
+#define _USE_MATH_DEFINES
+
+#include "spatial_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <tuple>
+
+namespace geo {
+
+namespace {
+
+// Длина одного градуса широты в метрах
+const double METERS_PER_DEGREE = M_PI / 180. * 6371000;
+const double DEFAULT_CELL_SIZE = 0.01;
+const size_t POINTS_PER_CELL = 2;
+
+// Размер ячейки подбирается так, чтобы на ячейку приходилось около POINTS_PER_CELL элементов
+void InitGrid(SpatialIndex::Grid& grid, const BoundingBox& bounds, size_t items_count) {
+    grid.min_lat = bounds.min.lat;
+    grid.min_lng = bounds.min.lng;
+    const double height = bounds.max.lat - bounds.min.lat;
+    const double width = bounds.max.lng - bounds.min.lng;
+
+    const double cells_count = std::max<double>(1.0, static_cast<double>(items_count / POINTS_PER_CELL));
+    // Вытянутая вдоль одной оси сеть не должна порождать больше cells_count строк или столбцов
+    grid.cell_size = std::max(std::sqrt(height * width / cells_count),
+        std::max({ height, width, DEFAULT_CELL_SIZE }) / cells_count);
+    grid.rows = static_cast<uint32_t>(height / grid.cell_size) + 1;
+    grid.cols = static_cast<uint32_t>(width / grid.cell_size) + 1;
+}
+
+uint32_t GetCell(double offset, double cell_size, uint32_t count) {
+    const double cell = std::floor(offset / cell_size);
+    return static_cast<uint32_t>(std::clamp(cell, 0.0, static_cast<double>(count - 1)));
+}
+
+} // namespace
+
+SpatialIndex::SpatialIndex(std::vector<Coordinates> points)
+    : points_(std::move(points))
+{
+    if (points_.empty()) {
+        return;
+    }
+
+    const auto [bottom_it, top_it] = std::minmax_element(points_.begin(), points_.end(),
+        [](const Coordinates& lhs, const Coordinates& rhs) { return lhs.lat < rhs.lat; });
+    const auto [left_it, right_it] = std::minmax_element(points_.begin(), points_.end(),
+        [](const Coordinates& lhs, const Coordinates& rhs) { return lhs.lng < rhs.lng; });
+    InitGrid(grid_, { { bottom_it->lat, left_it->lng }, { top_it->lat, right_it->lng } }, points_.size());
+
+    std::vector<uint32_t> cell_by_point(points_.size());
+    grid_.cell_offsets.assign(static_cast<size_t>(grid_.rows) * grid_.cols + 1, 0);
+    for (size_t i = 0; i < points_.size(); ++i) {
+        cell_by_point[i] = GetRow(points_[i].lat) * grid_.cols + GetCol(points_[i].lng);
+        ++grid_.cell_offsets[cell_by_point[i] + 1];
+    }
+    for (size_t cell = 1; cell < grid_.cell_offsets.size(); ++cell) {
+        grid_.cell_offsets[cell] += grid_.cell_offsets[cell - 1];
+    }
+
+    grid_.items.resize(points_.size());
+    std::vector<uint32_t> fill(grid_.cell_offsets.begin(), std::prev(grid_.cell_offsets.end()));
+    for (size_t i = 0; i < points_.size(); ++i) {
+        grid_.items[fill[cell_by_point[i]]++] = static_cast<uint32_t>(i);
+    }
+}
+
+bool SpatialIndex::Grid::Fits(size_t points_count) const {
+    if (rows == 0 || cols == 0 || !(cell_size > 0.0) || !std::isfinite(cell_size)) {
+        return false;
+    }
+    if (cell_offsets.size() != static_cast<size_t>(rows) * cols + 1 || cell_offsets.front() != 0
+        || cell_offsets.back() != items.size() || items.size() != points_count) {
+        return false;
+    }
+    if (!std::is_sorted(cell_offsets.begin(), cell_offsets.end())) {
+        return false;
+    }
+    std::vector<bool> seen(points_count, false);
+    for (const uint32_t item : items) {
+        if (item >= points_count || seen[item]) {
+            return false;
+        }
+        seen[item] = true;
+    }
+    return true;
+}
+
+SpatialIndex::SpatialIndex(Grid grid, std::vector<Coordinates> points)
+    : grid_(std::move(grid))
+    , points_(std::move(points))
+{
+}
+
+std::vector<std::pair<uint32_t, double>> SpatialIndex::FindNearest(Coordinates center, double radius, size_t limit) const {
+    std::vector<std::pair<uint32_t, double>> result;
+    if (IsEmpty() || limit == 0 || radius < 0.0) {
+        return result;
+    }
+
+    const double lat_delta = radius / METERS_PER_DEGREE;
+    const double lng_scale = std::max(std::cos(center.lat * M_PI / 180.), 1e-6);
+    const double lng_delta = lat_delta / lng_scale;
+
+    const double max_lat = grid_.min_lat + grid_.rows * grid_.cell_size;
+    const double max_lng = grid_.min_lng + grid_.cols * grid_.cell_size;
+    if (center.lat + lat_delta < grid_.min_lat || center.lat - lat_delta > max_lat
+        || center.lng + lng_delta < grid_.min_lng || center.lng - lng_delta > max_lng) {
+        return result;
+    }
+
+    const uint32_t row_from = GetRow(center.lat - lat_delta);
+    const uint32_t row_to = GetRow(center.lat + lat_delta);
+    const uint32_t col_from = GetCol(center.lng - lng_delta);
+    const uint32_t col_to = GetCol(center.lng + lng_delta);
+
+    for (uint32_t row = row_from; row <= row_to; ++row) {
+        const size_t first_cell = static_cast<size_t>(row) * grid_.cols;
+        for (uint32_t i = grid_.cell_offsets[first_cell + col_from]; i < grid_.cell_offsets[first_cell + col_to + 1]; ++i) {
+            const uint32_t point = grid_.items[i];
+            const double distance = ComputeDistance(center, points_[point]);
+            if (distance <= radius) {
+                result.emplace_back(point, distance);
+            }
+        }
+    }
+
+    auto by_distance = [](const auto& lhs, const auto& rhs) {
+        return std::tie(lhs.second, lhs.first) < std::tie(rhs.second, rhs.first);
+    };
+    if (result.size() > limit) {
+        std::partial_sort(result.begin(), result.begin() + limit, result.end(), by_distance);
+        result.resize(limit);
+    }
+    else {
+        std::sort(result.begin(), result.end(), by_distance);
+    }
+
+    return result;
+}
+
+const SpatialIndex::Grid& SpatialIndex::GetGrid() const {
+    return grid_;
+}
+
+bool SpatialIndex::IsEmpty() const {
+    return points_.empty() || grid_.rows == 0 || grid_.cols == 0;
+}
+
+uint32_t SpatialIndex::GetRow(double lat) const {
+    return GetCell(lat - grid_.min_lat, grid_.cell_size, grid_.rows);
+}
+
+uint32_t SpatialIndex::GetCol(double lng) const {
+    return GetCell(lng - grid_.min_lng, grid_.cell_size, grid_.cols);
+}
+
+BoxIndex::BoxIndex(std::vector<BoundingBox> boxes)
+    : boxes_(std::move(boxes))
+{
+    if (boxes_.empty()) {
+        return;
+    }
+
+    BoundingBox bounds = boxes_.front();
+    for (const BoundingBox& box : boxes_) {
+        bounds.Extend(box);
+    }
+    InitGrid(grid_, bounds, boxes_.size());
+
+    // Два прохода по ячейкам каждого прямоугольника: сначала подсчёт, затем раскладка
+    auto for_each_cell = [this](const BoundingBox& box, auto action) {
+        const uint32_t row_from = GetCell(box.min.lat - grid_.min_lat, grid_.cell_size, grid_.rows);
+        const uint32_t row_to = GetCell(box.max.lat - grid_.min_lat, grid_.cell_size, grid_.rows);
+        const uint32_t col_from = GetCell(box.min.lng - grid_.min_lng, grid_.cell_size, grid_.cols);
+        const uint32_t col_to = GetCell(box.max.lng - grid_.min_lng, grid_.cell_size, grid_.cols);
+        for (uint32_t row = row_from; row <= row_to; ++row) {
+            for (uint32_t col = col_from; col <= col_to; ++col) {
+                action(static_cast<size_t>(row) * grid_.cols + col);
+            }
+        }
+    };
+
+    grid_.cell_offsets.assign(static_cast<size_t>(grid_.rows) * grid_.cols + 1, 0);
+    for (const BoundingBox& box : boxes_) {
+        for_each_cell(box, [this](size_t cell) { ++grid_.cell_offsets[cell + 1]; });
+    }
+    for (size_t cell = 1; cell < grid_.cell_offsets.size(); ++cell) {
+        grid_.cell_offsets[cell] += grid_.cell_offsets[cell - 1];
+    }
+
+    grid_.items.resize(grid_.cell_offsets.back());
+    std::vector<uint32_t> fill(grid_.cell_offsets.begin(), std::prev(grid_.cell_offsets.end()));
+    for (size_t i = 0; i < boxes_.size(); ++i) {
+        for_each_cell(boxes_[i], [this, &fill, i](size_t cell) { grid_.items[fill[cell]++] = static_cast<uint32_t>(i); });
+    }
+}
+
+std::vector<uint32_t> BoxIndex::Find(const BoundingBox& area) const {
+    std::vector<uint32_t> result;
+    if (IsEmpty()) {
+        return result;
+    }
+
+    const BoundingBox grid_bounds = {
+        { grid_.min_lat, grid_.min_lng },
+        { grid_.min_lat + grid_.rows * grid_.cell_size, grid_.min_lng + grid_.cols * grid_.cell_size }
+    };
+    if (!area.Intersects(grid_bounds)) {
+        return result;
+    }
+
+    const uint32_t row_from = GetCell(area.min.lat - grid_.min_lat, grid_.cell_size, grid_.rows);
+    const uint32_t row_to = GetCell(area.max.lat - grid_.min_lat, grid_.cell_size, grid_.rows);
+    const uint32_t col_from = GetCell(area.min.lng - grid_.min_lng, grid_.cell_size, grid_.cols);
+    const uint32_t col_to = GetCell(area.max.lng - grid_.min_lng, grid_.cell_size, grid_.cols);
+
+    for (uint32_t row = row_from; row <= row_to; ++row) {
+        const size_t first_cell = static_cast<size_t>(row) * grid_.cols;
+        for (uint32_t i = grid_.cell_offsets[first_cell + col_from]; i < grid_.cell_offsets[first_cell + col_to + 1]; ++i) {
+            const uint32_t box = grid_.items[i];
+            if (area.Intersects(boxes_[box])) {
+                result.push_back(box);
+            }
+        }
+    }
+
+    // Прямоугольник, задевающий несколько ячеек, встречается несколько раз
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+bool BoxIndex::IsEmpty() const {
+    return boxes_.empty() || grid_.rows == 0 || grid_.cols == 0;
+}
+
+} // namespace geo
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "geo.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace geo {
+
+/*
+    * Равномерная сетка по широте и долготе поверх набора точек.
+    * Точки каждой ячейки лежат подряд в items_, границы ячеек хранятся в cell_offsets_,
+    * поэтому поиск соседей просматривает только ячейки, попавшие в радиус запроса
+    */
+class SpatialIndex {
+public:
+    struct Grid {
+        double min_lat = 0.0;
+        double min_lng = 0.0;
+        double cell_size = 0.0;
+        uint32_t rows = 0;
+        uint32_t cols = 0;
+        std::vector<uint32_t> cell_offsets;
+        std::vector<uint32_t> items;
+
+        // Сетка согласована: cell_offsets размечает ровно items, а каждая из points_count точек лежит в ней один раз
+        bool Fits(size_t points_count) const;
+    };
+
+    SpatialIndex() = default;
+    explicit SpatialIndex(std::vector<Coordinates> points);
+    SpatialIndex(Grid grid, std::vector<Coordinates> points);
+
+    // Возвращает не более limit пар (номер точки, расстояние в метрах), отсортированных по расстоянию
+    std::vector<std::pair<uint32_t, double>> FindNearest(Coordinates center, double radius, size_t limit) const;
+
+    const Grid& GetGrid() const;
+    bool IsEmpty() const;
+
+private:
+    uint32_t GetRow(double lat) const;
+    uint32_t GetCol(double lng) const;
+
+    Grid grid_;
+    std::vector<Coordinates> points_;
+};
+
+/*
+    * Та же сетка поверх набора прямоугольников. Прямоугольник записывается во все ячейки,
+    * которые он задевает, поэтому запрос области просматривает только ячейки внутри неё
+    */
+class BoxIndex {
+public:
+    BoxIndex() = default;
+    explicit BoxIndex(std::vector<BoundingBox> boxes);
+
+    // Номера прямоугольников, пересекающих area, по возрастанию
+    std::vector<uint32_t> Find(const BoundingBox& area) const;
+
+    bool IsEmpty() const;
+
+private:
+    SpatialIndex::Grid grid_;
+    std::vector<BoundingBox> boxes_;
+};
+
+} // namespace geo
@@ -0,0 +1,201 @@
+#pragma once
+
+#include "geo.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+namespace transport {
+
+/*
+    * Совершенная хеш-таблица над фиксированным набором имён, целиком вычисляемая при компиляции.
+    * Seed подбирается constexpr-перебором так, чтобы все имена попали в разные ячейки,
+    * поэтому поиск имени — один хеш, одна ячейка и одно сравнение строк
+    */
+template <size_t N>
+class StaticNameTable {
+public:
+    static constexpr size_t NOT_FOUND = N;
+
+    constexpr explicit StaticNameTable(const std::array<std::string_view, N>& names)
+        : names_(names)
+    {
+        while (!TryBuild()) {
+            ++seed_;
+        }
+    }
+
+    // Возвращает номер имени в исходном массиве или NOT_FOUND
+    constexpr size_t Find(std::string_view name) const {
+        const size_t index = slots_[Hash(name, seed_) & (SIZE - 1)];
+        return index != NOT_FOUND && names_[index] == name ? index : NOT_FOUND;
+    }
+
+private:
+    static constexpr size_t GetSize() {
+        size_t size = 1;
+        while (size < 2 * N) {
+            size *= 2;
+        }
+        return size;
+    }
+
+    static constexpr size_t SIZE = GetSize();
+
+    static constexpr uint32_t Hash(std::string_view name, uint32_t seed) {
+        uint32_t hash = 2166136261u ^ seed;
+        for (const char c : name) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 16777619u;
+        }
+        return hash ^ (hash >> 16);
+    }
+
+    constexpr bool TryBuild() {
+        for (size_t& slot : slots_) {
+            slot = NOT_FOUND;
+        }
+        for (size_t i = 0; i < N; ++i) {
+            size_t& slot = slots_[Hash(names_[i], seed_) & (SIZE - 1)];
+            if (slot != NOT_FOUND) {
+                return false;
+            }
+            slot = i;
+        }
+        return true;
+    }
+
+    std::array<std::string_view, N> names_{};
+    std::array<size_t, SIZE> slots_{};
+    uint32_t seed_ = 0;
+};
+
+// Поля запросов к базе. Порядок совпадает с REQUEST_FIELD_NAMES, UNKNOWN — последний
+enum class RequestField {
+    ID,
+    TYPE,
+    NAME,
+    FROM,
+    TO,
+    FROM_COORDINATES,
+    TO_COORDINATES,
+    WALKING_SPEED,
+    STOPS,
+    BUS,
+    LATITUDE,
+    LONGITUDE,
+    RADIUS,
+    LIMIT,
+    PREFIX,
+    MAX_EDITS,
+    VIEWPORT,
+    ZOOM,
+    UNKNOWN
+};
+
+inline constexpr std::array<std::string_view, static_cast<size_t>(RequestField::UNKNOWN)> REQUEST_FIELD_NAMES = {
+    "id", "type", "name", "from", "to", "from_coordinates", "to_coordinates", "walking_speed",
+    "stops", "bus", "latitude", "longitude", "radius", "limit", "prefix", "max_edits",
+    "viewport", "zoom"
+};
+
+// Типы запросов к базе. Порядок совпадает с REQUEST_TYPE_NAMES, UNKNOWN — последний
+enum class RequestType {
+    STOP,
+    BUS,
+    MAP,
+    ROUTE,
+    COMMON_BUSES,
+    ROUTE_SEGMENT,
+    NEAREST_STOPS,
+    STOP_SEARCH,
+    UNKNOWN
+};
+
+inline constexpr std::array<std::string_view, static_cast<size_t>(RequestType::UNKNOWN)> REQUEST_TYPE_NAMES = {
+    "Stop", "Bus", "Map", "Route", "CommonBuses", "RouteSegment", "NearestStops", "StopSearch"
+};
+
+inline RequestField ParseRequestField(std::string_view name) {
+    static constexpr StaticNameTable<REQUEST_FIELD_NAMES.size()> table(REQUEST_FIELD_NAMES);
+    return static_cast<RequestField>(table.Find(name));
+}
+
+inline RequestType ParseRequestType(std::string_view name) {
+    static constexpr StaticNameTable<REQUEST_TYPE_NAMES.size()> table(REQUEST_TYPE_NAMES);
+    return static_cast<RequestType>(table.Find(name));
+}
+
+/*
+    * Разобранные запросы к базе. Строки ссылаются на документ, из которого запрос прочитан,
+    * и действительны, пока жив этот документ
+    */
+struct StopRequest {
+    int id = 0;
+    std::string_view name;
+};
+
+struct BusRequest {
+    int id = 0;
+    std::string_view name;
+};
+
+// Без окна и масштаба запрос получает готовую карту из базы
+struct MapRequest {
+    int id = 0;
+    std::optional<geo::BoundingBox> viewport;
+    std::optional<int> zoom;
+};
+
+struct RouteRequest {
+    int id = 0;
+    std::string_view from;
+    std::string_view to;
+};
+
+struct CoordinatesRouteRequest {
+    int id = 0;
+    geo::Coordinates from = { 0.0, 0.0 };
+    geo::Coordinates to = { 0.0, 0.0 };
+    double walking_speed = 0.0;
+};
+
+struct CommonBusesRequest {
+    int id = 0;
+    std::vector<std::string_view> stops;
+};
+
+struct RouteSegmentRequest {
+    int id = 0;
+    std::string_view bus;
+    std::string_view from;
+    std::string_view to;
+};
+
+struct NearestStopsRequest {
+    int id = 0;
+    geo::Coordinates center = { 0.0, 0.0 };
+    double radius = 0.0;
+    int limit = 0;
+};
+
+struct StopSearchRequest {
+    int id = 0;
+    std::string_view prefix;
+    int max_edits = 0;
+    int limit = 10;
+};
+
+// Запрос неизвестного типа остаётся без ответа, id нужен только построчному режиму
+struct UnknownRequest {
+    std::optional<int> id;
+};
+
+using StatRequest = std::variant<UnknownRequest, StopRequest, BusRequest, MapRequest, RouteRequest, CoordinatesRouteRequest,
+    CommonBusesRequest, RouteSegmentRequest, NearestStopsRequest, StopSearchRequest>;
+
+} // namespace transport
@@ -0,0 +1,38 @@
+#include "string_arena.h"
+
+#include <algorithm>
+
+namespace transport {
+
+void StringArena::Reserve(size_t string_count) {
+    strings_.reserve(string_count);
+}
+
+std::string_view StringArena::InternView(std::string_view str) {
+    if (const auto it = strings_.find(str); it != strings_.end()) {
+        return *it;
+    }
+    return *strings_.insert(Store(str)).first;
+}
+
+std::string_view StringArena::Store(std::string_view str) {
+    if (str.empty()) {
+        return {};
+    }
+    // Длинная строка получает собственный блок, не сбрасывая текущий
+    if (str.size() > BLOCK_SIZE / 4) {
+        const auto& block = large_blocks_.emplace_back(std::make_unique<char[]>(str.size()));
+        std::copy(str.begin(), str.end(), block.get());
+        return { block.get(), str.size() };
+    }
+    if (BLOCK_SIZE - block_used_ < str.size()) {
+        blocks_.emplace_back(std::make_unique<char[]>(BLOCK_SIZE));
+        block_used_ = 0;
+    }
+    char* data = blocks_.back().get() + block_used_;
+    std::copy(str.begin(), str.end(), data);
+    block_used_ += str.size();
+    return { data, str.size() };
+}
+
+} // namespace transport
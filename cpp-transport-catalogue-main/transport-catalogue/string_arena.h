@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace transport {
+
+/*
+    * Хранилище имён остановок и маршрутов, в которое строки только добавляются.
+    * Каждая строка хранится в единственном экземпляре внутри крупных блоков памяти,
+    * а наружу отдаётся string_view.
+    * Блоки не перемещаются, поэтому выданные string_view остаются валидными
+    * и после перемещения самого хранилища
+    */
+class StringArena {
+public:
+    StringArena() = default;
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+    StringArena(StringArena&&) = default;
+    StringArena& operator=(StringArena&&) = default;
+
+    void Reserve(size_t string_count);
+    std::string_view InternView(std::string_view str);
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    std::string_view Store(std::string_view str);
+
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    std::vector<std::unique_ptr<char[]>> large_blocks_;
+    size_t block_used_ = BLOCK_SIZE;
+    std::unordered_set<std::string_view> strings_;
+};
+
+} // namespace transport
@@ -1,9 +1,152 @@
 #include "svg.h"
 
+#include <charconv>
+
 namespace svg {
 
 using namespace std::literals;
 
+namespace detail {
+
+// При precision = DEFAULT_PRECISION числа выводятся так же, как оператором << потока с настройками по умолчанию
+void AppendNumber(std::string& out, double value, int precision) {
+    char chars[64];
+    const auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), value, std::chars_format::general, precision);
+    out.append(chars, end);
+}
+
+void AppendColor(std::string& out, const Color& color) {
+    if (const auto* name = std::get_if<std::string>(&color)) {
+        out += *name;
+        return;
+    }
+    if (std::holds_alternative<std::monostate>(color)) {
+        out += "none"sv;
+        return;
+    }
+    const bool has_opacity = std::holds_alternative<Rgba>(color);
+    const Rgb& rgb = has_opacity ? std::get<Rgba>(color) : std::get<Rgb>(color);
+    out += has_opacity ? "rgba("sv : "rgb("sv;
+    for (const uint8_t channel : { rgb.red, rgb.green, rgb.blue }) {
+        char chars[4];
+        const auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), static_cast<int>(channel));
+        out.append(chars, end);
+        out += ',';
+    }
+    if (has_opacity) {
+        AppendNumber(out, std::get<Rgba>(color).opacity);
+    }
+    else {
+        out.pop_back();
+    }
+    out += ')';
+}
+
+void AppendLineCap(std::string& out, StrokeLineCap line_cap) {
+    switch (line_cap) {
+    case StrokeLineCap::BUTT:
+        out += "butt"sv;
+        break;
+    case StrokeLineCap::ROUND:
+        out += "round"sv;
+        break;
+    case StrokeLineCap::SQUARE:
+        out += "square"sv;
+        break;
+    }
+}
+
+void AppendLineJoin(std::string& out, StrokeLineJoin line_join) {
+    switch (line_join) {
+    case StrokeLineJoin::ARCS:
+        out += "arcs"sv;
+        break;
+    case StrokeLineJoin::BEVEL:
+        out += "bevel"sv;
+        break;
+    case StrokeLineJoin::MITER:
+        out += "miter"sv;
+        break;
+    case StrokeLineJoin::MITER_CLIP:
+        out += "miter-clip"sv;
+        break;
+    case StrokeLineJoin::ROUND:
+        out += "round"sv;
+        break;
+    }
+}
+
+} // namespace detail
+
+namespace {
+
+using detail::AppendNumber;
+
+void AppendInteger(std::string& out, uint32_t value) {
+    char chars[16];
+    const auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), value);
+    out.append(chars, end);
+}
+
+void AppendCircle(std::string& out, Point center, double radius, std::string_view style, int precision) {
+    out += "<circle cx=\""sv;
+    AppendNumber(out, center.x, precision);
+    out += "\" cy=\""sv;
+    AppendNumber(out, center.y, precision);
+    out += "\" r=\""sv;
+    AppendNumber(out, radius, precision);
+    out += '"';
+    out += style;
+    out += "/>"sv;
+}
+
+void AppendPolylinePoint(std::string& out, Point point, bool is_first, int precision) {
+    if (!is_first) {
+        out += ' ';
+    }
+    AppendNumber(out, point.x, precision);
+    out += ',';
+    AppendNumber(out, point.y, precision);
+}
+
+void AppendPolylineEnd(std::string& out, std::string_view style) {
+    out += '"';
+    out += style;
+    out += "/>"sv;
+}
+
+void AppendText(std::string& out, Point position, Point offset, uint32_t font_size, std::string_view font_family,
+    std::string_view font_weight, std::string_view data, std::string_view style, int precision) {
+    out += "<text"sv;
+    out += style;
+    out += " x=\""sv;
+    AppendNumber(out, position.x, precision);
+    out += "\" y=\""sv;
+    AppendNumber(out, position.y, precision);
+    out += "\" dx=\""sv;
+    AppendNumber(out, offset.x, precision);
+    out += "\" dy=\""sv;
+    AppendNumber(out, offset.y, precision);
+    out += "\" font-size=\""sv;
+    AppendInteger(out, font_size);
+    out += '"';
+    if (!font_family.empty()) {
+        out += " font-family=\""sv;
+        out += font_family;
+        out += "\" "sv;
+    }
+    if (!font_weight.empty()) {
+        out += "font-weight=\""sv;
+        out += font_weight;
+        out += '"';
+    }
+    out += '>';
+    out += data;
+    out += "</text>"sv;
+}
+
+} // namespace
+
 std::ostream& operator<<(std::ostream& out, Color& color) {
     std::visit(ColorPrinter{ out }, color);
     return out;
@@ -50,7 +193,7 @@ void Object::Render(const RenderContext& context) const {
     // Делегируем вывод тега своим подклассам
     RenderObject(context);
 
-    context.out << std::endl;
+    context.buffer += '\n';
 }
 
 // ---------- Circle ------------------
@@ -66,12 +209,7 @@ Circle& Circle::SetRadius(double radius) {
 }
 
 void Circle::RenderObject(const RenderContext& context) const {
-    auto& out = context.out;
-    out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
-    out << "r=\""sv << radius_ << "\""sv;
-    // Выводим атрибуты, унаследованные от PathProps
-    RenderAttrs(context.out);
-    out << "/>"sv;
+    AppendCircle(context.buffer, center_, radius_, FormatAttrs(), context.precision);
 }
 
 // ---------- Polyline ----------------
@@ -82,22 +220,11 @@ Polyline& Polyline::AddPoint(Point point) {
 }
 
 void Polyline::RenderObject(const RenderContext& context) const {
-    auto& out = context.out;
-    out << "<polyline points=\""sv;
-    bool is_first = true;
-    for (auto& point : points_) {
-        if (is_first) {
-            out << point.x << "," << point.y;
-            is_first = false;
-        }
-        else {
-            out << " "sv << point.x << "," << point.y;
-        }
+    context.buffer += "<polyline points=\""sv;
+    for (size_t i = 0; i < points_.size(); ++i) {
+        AppendPolylinePoint(context.buffer, points_[i], i == 0, context.precision);
     }
-    out << "\"";
-    // Выводим атрибуты, унаследованные от PathProps
-    RenderAttrs(context.out);
-    out << "/>"sv;
+    AppendPolylineEnd(context.buffer, FormatAttrs());
 }
 
 // ---------- Text --------------------
@@ -133,16 +260,58 @@ Text& Text::SetData(std::string data) {
 }
 
 void Text::RenderObject(const RenderContext& context) const {
-    auto& out = context.out;
-    out << "<text";
-    // Выводим атрибуты, унаследованные от PathProps
-    RenderAttrs(context.out);
-    out << " x=\""sv << pos_.x << "\" y=\""sv << pos_.y << "\" "sv;
-    out << "dx=\""sv << offset_.x << "\" dy=\""sv << offset_.y << "\" "sv;
-    out << "font-size=\""sv << size_ << "\""sv;
-    if (!font_family_.empty()) out << " font-family=\""sv << font_family_ << "\" "sv;
-    if (!font_weight_.empty()) out << "font-weight=\""sv << font_weight_ << "\""sv;
-    out << ">"sv << data_ << "</text>"sv;
+    AppendText(context.buffer, pos_, offset_, size_, font_family_, font_weight_, data_, FormatAttrs(), context.precision);
+}
+
+// ---------- Style -------------------
+
+std::string Style::Format() const {
+    return FormatAttrs();
+}
+
+// ---------- Writer ------------------
+
+Writer::Writer(std::string& buffer, int precision)
+    : buffer_(buffer)
+    , precision_(precision)
+{
+}
+
+void Writer::StartDocument() {
+    buffer_ += "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+    buffer_ += "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
+}
+
+void Writer::EndDocument() {
+    buffer_ += "</svg>"sv;
+}
+
+void Writer::Circle(Point center, double radius, std::string_view style) {
+    buffer_ += "  "sv;
+    AppendCircle(buffer_, center, radius, style, precision_);
+    buffer_ += '\n';
+}
+
+void Writer::StartPolyline() {
+    buffer_ += "  <polyline points=\""sv;
+    is_first_point_ = true;
+}
+
+void Writer::AddPoint(Point point) {
+    AppendPolylinePoint(buffer_, point, is_first_point_, precision_);
+    is_first_point_ = false;
+}
+
+void Writer::EndPolyline(std::string_view style) {
+    AppendPolylineEnd(buffer_, style);
+    buffer_ += '\n';
+}
+
+void Writer::Text(Point position, Point offset, uint32_t font_size, std::string_view font_family,
+    std::string_view font_weight, std::string_view data, std::string_view style) {
+    buffer_ += "  "sv;
+    AppendText(buffer_, position, offset, font_size, font_family, font_weight, data, style, precision_);
+    buffer_ += '\n';
 }
 
 // ---------- Document ----------------
@@ -151,14 +320,16 @@ void Document::AddPtr(std::unique_ptr<Object>&& obj) {
     objects_.emplace_back(std::move(obj));
 }
 
-void Document::Render(std::ostream& out) const {
-    RenderContext ctx(out, 2, 2);
-    out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-    out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
+void Document::Render(std::ostream& out, int precision) const {
+    std::string buffer;
+    Writer writer(buffer, precision);
+    writer.StartDocument();
+    RenderContext ctx(buffer, 2, 2, precision);
     for (const auto& obj : objects_) {
         obj->Render(ctx);
     }
-    out << "</svg>"sv;
+    writer.EndDocument();
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
 }
 
 } // namespace svg
\ No newline at end of file
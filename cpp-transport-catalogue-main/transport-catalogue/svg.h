@@ -4,6 +4,7 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <variant>
@@ -95,34 +96,44 @@ struct Point {
     double y = 0;
 };
 
+// Число значащих цифр координат и размеров по умолчанию, как у потока вывода без настроек
+inline constexpr int DEFAULT_PRECISION = 6;
+
+namespace detail {
+
+// Дописывают значения в буфер без участия потоков и локали
+void AppendNumber(std::string& out, double value, int precision = DEFAULT_PRECISION);
+void AppendColor(std::string& out, const Color& color);
+void AppendLineCap(std::string& out, StrokeLineCap line_cap);
+void AppendLineJoin(std::string& out, StrokeLineJoin line_join);
+
+} // namespace detail
+
 /*
     * Вспомогательная структура, хранящая контекст для вывода SVG-документа с отступами.
-    * Хранит ссылку на поток вывода, текущее значение и шаг отступа при выводе элемента
+    * Элементы дописываются в общий буфер, который выводится в поток один раз в конце документа.
+    * precision — число значащих цифр координат
     */
 struct RenderContext {
-    RenderContext(std::ostream& out)
-        : out(out) {
-    }
-
-    RenderContext(std::ostream& out, int indent_step, int indent = 0)
-        : out(out)
+    explicit RenderContext(std::string& buffer, int indent_step = 0, int indent = 0, int precision = DEFAULT_PRECISION)
+        : buffer(buffer)
         , indent_step(indent_step)
-        , indent(indent) {
+        , indent(indent)
+        , precision(precision) {
     }
 
     RenderContext Indented() const {
-        return { out, indent_step, indent + indent_step };
+        return RenderContext(buffer, indent_step, indent + indent_step, precision);
     }
 
     void RenderIndent() const {
-        for (int i = 0; i < indent; ++i) {
-            out.put(' ');
-        }
+        buffer.append(static_cast<size_t>(indent), ' ');
     }
 
-    std::ostream& out;
+    std::string& buffer;
     int indent_step = 0;
     int indent = 0;
+    int precision = DEFAULT_PRECISION;
 };
 
 /*
@@ -201,27 +212,39 @@ public:
 protected:
     ~PathProps() = default;
 
-    void RenderAttrs(std::ostream& out) const {
+    std::string FormatAttrs() const {
+        std::string out;
+        RenderAttrs(out);
+        return out;
+    }
+
+    void RenderAttrs(std::string& out) const {
         using namespace std::literals;
 
         if (fill_color_) {
-            out << " fill=\""sv;
-            std::visit(ColorPrinter{ out }, *fill_color_);
-            out << "\""sv;
+            out += " fill=\""sv;
+            detail::AppendColor(out, *fill_color_);
+            out += '"';
         }
         if (stroke_color_) {
-            out << " stroke=\""sv;
-            std::visit(ColorPrinter{ out }, *stroke_color_);
-            out << "\""sv;
+            out += " stroke=\""sv;
+            detail::AppendColor(out, *stroke_color_);
+            out += '"';
         }
         if (width_) {
-            out << " stroke-width=\""sv << *width_ << "\""sv;
+            out += " stroke-width=\""sv;
+            detail::AppendNumber(out, *width_);
+            out += '"';
         }
         if (line_cap_) {
-            out << " stroke-linecap=\""sv << *line_cap_ << "\""sv;
+            out += " stroke-linecap=\""sv;
+            detail::AppendLineCap(out, *line_cap_);
+            out += '"';
         }
         if (line_join_) {
-            out << " stroke-linejoin=\""sv << *line_join_ << "\""sv;
+            out += " stroke-linejoin=\""sv;
+            detail::AppendLineJoin(out, *line_join_);
+            out += '"';
         }
     }
 
@@ -305,13 +328,54 @@ private:
     std::string data_;
 };
 
+/*
+    * Атрибуты заливки и контура, один раз отформатированные в строку.
+    * Writer подставляет готовую строку, поэтому цвет палитры форматируется один раз, а не для каждого элемента
+    */
+class Style final : public PathProps<Style> {
+public:
+    std::string Format() const;
+};
+
+/*
+    * Потоковая запись SVG в растущий буфер без промежуточных объектов и виртуальных вызовов.
+    * Элементы выводятся байт в байт так же, как через Document: с отступом в два пробела, по одному на строку.
+    * style — строка атрибутов из Style::Format
+    */
+class Writer {
+public:
+    explicit Writer(std::string& buffer, int precision = DEFAULT_PRECISION);
+
+    void StartDocument();
+    void EndDocument();
+
+    void Circle(Point center, double radius, std::string_view style);
+
+    // Вершины ломаной передаются между StartPolyline и EndPolyline
+    void StartPolyline();
+    void AddPoint(Point point);
+    void EndPolyline(std::string_view style);
+
+    void Text(Point position, Point offset, uint32_t font_size, std::string_view font_family,
+        std::string_view font_weight, std::string_view data, std::string_view style);
+
+private:
+    std::string& buffer_;
+    int precision_;
+    bool is_first_point_ = true;
+};
+
+/*
+    * Документ из полиморфных объектов, оставлен для совместимости.
+    * Объекты форматируются теми же функциями, что и Writer
+    */
 class Document : public ObjectContainer {
 public:
     // Добавляет в svg-документ объект-наследник svg::Object
     void AddPtr(std::unique_ptr<Object>&& obj) override;
 
-    // Выводит в ostream svg-представление документа
-    void Render(std::ostream& out) const;
+    // Выводит в ostream svg-представление документа одной записью, координаты — с precision значащими цифрами
+    void Render(std::ostream& out, int precision = DEFAULT_PRECISION) const;
 
 private:
     std::vector<std::unique_ptr<Object>> objects_;
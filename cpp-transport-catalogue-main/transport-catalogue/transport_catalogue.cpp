@@ -1,33 +1,95 @@
 #include "transport_catalogue.h"
 
+#include <algorithm>
+#include <functional>
+#include <future>
+
 namespace transport {
 
+namespace {
+
+// Пересечение отсортированных списков без ветвлений внутри цикла слияния
+void IntersectSorted(const std::vector<uint32_t>& lhs, const std::vector<uint32_t>& rhs, std::vector<uint32_t>& result) {
+    result.clear();
+    result.reserve(std::min(lhs.size(), rhs.size()));
+    size_t i = 0;
+    size_t j = 0;
+    while (i < lhs.size() && j < rhs.size()) {
+        const uint32_t left = lhs[i];
+        const uint32_t right = rhs[j];
+        if (left == right) {
+            result.push_back(left);
+        }
+        i += left <= right;
+        j += right <= left;
+    }
+}
+
+using StopPosition = std::pair<const Stop*, uint32_t>;
+
+bool StopPositionLess(const StopPosition& lhs, const StopPosition& rhs) {
+    if (lhs.first != rhs.first) {
+        return std::less<const Stop*>{}(lhs.first, rhs.first);
+    }
+    return lhs.second < rhs.second;
+}
+
+// Первая позиция остановки в маршруте не раньше from, бинарным поиском по stop_positions
+std::optional<size_t> FindStopPosition(const Bus& bus, const Stop* stop, size_t from) {
+    const auto it = std::lower_bound(bus.stop_positions.begin(), bus.stop_positions.end(),
+        StopPosition{ stop, static_cast<uint32_t>(from) }, StopPositionLess);
+    if (it == bus.stop_positions.end() || it->first != stop) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+} // namespace
+
+void TransportCatalogue::Reserve(size_t stop_count, size_t bus_count, size_t distance_count) {
+    names_.Reserve(stop_count + bus_count);
+    stopname_to_stop_.reserve(stop_count);
+    busname_to_bus_.reserve(bus_count);
+    stop_distances_.reserve(distance_count);
+}
+
 void TransportCatalogue::AddStop(std::string_view stop_name, const geo::Coordinates coordinates) {
-    all_stops_.push_back({ std::string(stop_name), coordinates, {} });
+    all_stops_.push_back({ names_.InternView(stop_name), coordinates, {} });
     stopname_to_stop_[all_stops_.back().name] = &all_stops_.back();
+    sorted_stops_.clear();
+    stop_names_ = {};
+    stop_search_ = {};
 }
 
 void TransportCatalogue::AddRoute(std::string_view bus_number, const std::vector<const Stop*> stops, bool is_circle) {
-    all_buses_.push_back({ std::string(bus_number), stops, is_circle });
+    all_buses_.push_back({ names_.InternView(bus_number), stops, is_circle, {}, {}, {}, {} });
+    FillRouteDistances(all_buses_.back());
     busname_to_bus_[all_buses_.back().number] = &all_buses_.back();
-    for (const auto& route_stop : stops) {
-        for (auto& stop_ : all_stops_) {
-            if (stop_.name == route_stop->name) stop_.buses_by_stop.insert(std::string(bus_number));
-        }
-    }
+    sorted_buses_.clear();
+    bus_names_ = {};
 }
 
 const Bus* TransportCatalogue::FindRoute(std::string_view bus_number) const {
-    return busname_to_bus_.count(bus_number) ? busname_to_bus_.at(bus_number) : nullptr;
+    if (!bus_names_.IsEmpty()) {
+        const auto id = bus_names_.Find(bus_number);
+        return id && *id < all_buses_.size() && all_buses_[*id].number == bus_number ? &all_buses_[*id] : nullptr;
+    }
+    const auto it = busname_to_bus_.find(bus_number);
+    return it != busname_to_bus_.end() ? it->second : nullptr;
 }
 
 const Stop* TransportCatalogue::FindStop(std::string_view stop_name) const {
-    return stopname_to_stop_.count(stop_name) ? stopname_to_stop_.at(stop_name) : nullptr;
+    if (!stop_names_.IsEmpty()) {
+        const auto id = stop_names_.Find(stop_name);
+        return id && *id < all_stops_.size() && all_stops_[*id].name == stop_name ? &all_stops_[*id] : nullptr;
+    }
+    const auto it = stopname_to_stop_.find(stop_name);
+    return it != stopname_to_stop_.end() ? it->second : nullptr;
 }
 
 size_t TransportCatalogue::UniqueStopsCount(std::string_view bus_number) const {
     std::unordered_set<std::string_view> unique_stops;
-    for (const auto& stop : busname_to_bus_.at(bus_number)->stops) {
+    for (const auto& stop : FindRoute(bus_number)->stops) {
         unique_stops.insert(stop->name);
     }
     return unique_stops.size();
@@ -43,20 +105,44 @@ int TransportCatalogue::GetDistance(const Stop* from, const Stop* to) const {
     else return 0;
 }
 
-const std::map<std::string_view, const Bus*> TransportCatalogue::GetSortedAllBuses() const {
-    std::map<std::string_view, const Bus*> result;
-    for (const auto& bus : busname_to_bus_) {
-        result.emplace(bus);
-    }
-    return result;
+void TransportCatalogue::Finalize() {
+    BuildSortedIndex();
+    // Индексы пишут в разные поля и только читают остановки и маршруты
+    auto bus_index = std::async(std::launch::async, [this] { BuildBusIndex(); });
+    auto stop_index = std::async(std::launch::async, [this] { BuildStopIndex(); });
+    auto search_index = std::async(std::launch::async, [this] { BuildSearchIndex(); });
+    BuildNameIndex();
+    bus_index.get();
+    stop_index.get();
+    search_index.get();
 }
 
-const std::map<std::string_view, const Stop*> TransportCatalogue::GetSortedAllStops() const {
-    std::map<std::string_view, const Stop*> result;
-    for (const auto& stop : stopname_to_stop_) {
-        result.emplace(stop);
+void TransportCatalogue::BuildSortedIndex() {
+    sorted_buses_.clear();
+    sorted_buses_.reserve(busname_to_bus_.size());
+    for (const auto& [bus_number, bus] : busname_to_bus_) {
+        sorted_buses_.push_back(bus);
     }
-    return result;
+    std::sort(sorted_buses_.begin(), sorted_buses_.end(), [](const Bus* lhs, const Bus* rhs) {
+        return lhs->number < rhs->number;
+    });
+
+    sorted_stops_.clear();
+    sorted_stops_.reserve(stopname_to_stop_.size());
+    for (const auto& [stop_name, stop] : stopname_to_stop_) {
+        sorted_stops_.push_back(stop);
+    }
+    std::sort(sorted_stops_.begin(), sorted_stops_.end(), [](const Stop* lhs, const Stop* rhs) {
+        return lhs->name < rhs->name;
+    });
+}
+
+BusesRange TransportCatalogue::GetSortedAllBuses() const {
+    return ranges::AsRange(sorted_buses_);
+}
+
+StopsRange TransportCatalogue::GetSortedAllStops() const {
+    return ranges::AsRange(sorted_stops_);
 }
 
 const std::unordered_map<std::pair<const Stop*, const Stop*>, int, TransportCatalogue::StopDistancesHasher> TransportCatalogue::GetStopDistances() const {
@@ -65,7 +151,7 @@ const std::unordered_map<std::pair<const Stop*, const Stop*>, int, TransportCata
     
 std::optional<transport::BusStat> TransportCatalogue::GetBusStat(const std::string_view bus_number) const {
     transport::BusStat bus_stat{};
-    const transport::Bus* bus = catalogue_.FindRoute(bus_number);
+    const transport::Bus* bus = FindRoute(bus_number);
 
     if (!bus) throw std::invalid_argument("bus not found");
     if (bus->is_circle) bus_stat.stops_count = bus->stops.size();
@@ -74,27 +160,251 @@ std::optional<transport::BusStat> TransportCatalogue::GetBusStat(const std::stri
     int route_length = 0;
     double geographic_length = 0.0;
 
-    for (size_t i = 0; i < bus->stops.size() - 1; ++i) {
-        auto from = bus->stops[i];
-        auto to = bus->stops[i + 1];
-        if (bus->is_circle) {
-            route_length += catalogue_.GetDistance(from, to);
-            geographic_length += geo::ComputeDistance(from->coordinates,
-                to->coordinates);
-        }
-        else {
-            route_length += catalogue_.GetDistance(from, to) + catalogue_.GetDistance(to, from);
-            geographic_length += geo::ComputeDistance(from->coordinates,
-                to->coordinates) * 2;
+    if (!bus->stops.empty()) {
+        route_length = bus->forward_distances.back();
+        geographic_length = bus->geo_distances.back();
+        if (!bus->is_circle) {
+            route_length += bus->backward_distances.back();
+            geographic_length *= 2;
         }
     }
 
-    bus_stat.unique_stops_count = catalogue_.UniqueStopsCount(bus_number);
+    bus_stat.unique_stops_count = UniqueStopsCount(bus_number);
     bus_stat.route_length = route_length;
     bus_stat.curvature = route_length / geographic_length;
 
     return bus_stat;
 }
 
-}    
+std::optional<transport::RouteSegmentStat> TransportCatalogue::GetRouteSegmentStat(std::string_view bus_number, std::string_view stop_from, std::string_view stop_to) const {
+    const Bus* bus = FindRoute(bus_number);
+    const Stop* from = FindStop(stop_from);
+    const Stop* to = FindStop(stop_to);
+    if (!bus || !from || !to) {
+        return std::nullopt;
+    }
+
+    const std::optional<size_t> from_position = FindStopPosition(*bus, from, 0);
+    if (!from_position) {
+        return std::nullopt;
+    }
+    const size_t i = *from_position;
+    // Ищем ближайшее вхождение конечной остановки по ходу движения автобуса
+    std::optional<size_t> to_position = FindStopPosition(*bus, to, i);
+    if (!to_position) {
+        to_position = FindStopPosition(*bus, to, 0);
+    }
+    if (!to_position || *to_position == i) {
+        return std::nullopt;
+    }
+    const size_t j = *to_position;
+    const size_t last = bus->stops.size() - 1;
+
+    if (i < j) {
+        return transport::RouteSegmentStat{
+            j - i,
+            bus->forward_distances[j] - bus->forward_distances[i],
+            bus->geo_distances[j] - bus->geo_distances[i]
+        };
+    }
+    if (!bus->is_circle) {
+        return transport::RouteSegmentStat{
+            i - j,
+            bus->backward_distances[i] - bus->backward_distances[j],
+            bus->geo_distances[i] - bus->geo_distances[j]
+        };
+    }
+    // Кольцевой маршрут: доезжаем до конечной и продолжаем круг с начала
+    return transport::RouteSegmentStat{
+        last - i + j,
+        bus->forward_distances[last] - bus->forward_distances[i] + bus->forward_distances[j],
+        bus->geo_distances[last] - bus->geo_distances[i] + bus->geo_distances[j]
+    };
+}
+
+const std::deque<Stop>& TransportCatalogue::GetAllStops() const {
+    return all_stops_;
+}
+
+const std::deque<Bus>& TransportCatalogue::GetAllBuses() const {
+    return all_buses_;
+}
+
+std::string_view TransportCatalogue::InternName(std::string_view name) {
+    return names_.InternView(name);
+}
+
+void TransportCatalogue::BuildStopIndex() {
+    stop_index_ = geo::SpatialIndex(GetStopsCoordinates());
+}
+
+void TransportCatalogue::SetStopIndex(geo::SpatialIndex::Grid grid) {
+    // Сетка из базы, не совпадающая с остановками каталога, строится заново
+    if (!grid.Fits(all_stops_.size())) {
+        BuildStopIndex();
+        return;
+    }
+    stop_index_ = geo::SpatialIndex(std::move(grid), GetStopsCoordinates());
+}
+
+const geo::SpatialIndex& TransportCatalogue::GetStopIndex() const {
+    return stop_index_;
+}
+
+std::vector<std::pair<const Stop*, double>> TransportCatalogue::FindNearestStops(geo::Coordinates center, double radius, size_t limit) const {
+    std::vector<std::pair<const Stop*, double>> result;
+    for (const auto& [stop_id, distance] : stop_index_.FindNearest(center, radius, limit)) {
+        result.emplace_back(&all_stops_[stop_id], distance);
+    }
+    return result;
+}
+
+void TransportCatalogue::BuildBusIndex() {
+    std::unordered_map<const Stop*, size_t> stop_ids;
+    stop_ids.reserve(all_stops_.size());
+    for (size_t i = 0; i < all_stops_.size(); ++i) {
+        stop_ids.emplace(&all_stops_[i], i);
+    }
+
+    std::vector<std::vector<uint32_t>> bus_ids_by_stop(all_stops_.size());
+    for (uint32_t bus_id = 0; bus_id < sorted_buses_.size(); ++bus_id) {
+        for (const Stop* stop : sorted_buses_[bus_id]->stops) {
+            auto& bus_ids = bus_ids_by_stop[stop_ids.at(stop)];
+            if (bus_ids.empty() || bus_ids.back() != bus_id) {
+                bus_ids.push_back(bus_id);
+            }
+        }
+    }
+    SetBusIndex(std::move(bus_ids_by_stop));
+}
+
+void TransportCatalogue::SetBusIndex(std::vector<std::vector<uint32_t>> bus_ids_by_stop) {
+    for (size_t i = 0; i < all_stops_.size() && i < bus_ids_by_stop.size(); ++i) {
+        all_stops_[i].bus_ids = std::move(bus_ids_by_stop[i]);
+    }
+}
+
+std::vector<std::string_view> TransportCatalogue::GetBusesByStop(const Stop* stop) const {
+    std::vector<std::string_view> result;
+    result.reserve(stop->bus_ids.size());
+    for (const uint32_t bus_id : stop->bus_ids) {
+        result.push_back(sorted_buses_[bus_id]->number);
+    }
+    return result;
+}
+
+std::vector<std::string_view> TransportCatalogue::GetCommonBuses(const std::vector<const Stop*>& stops) const {
+    if (stops.empty()) {
+        return {};
+    }
+    // Начинаем с самого короткого списка, чтобы промежуточный результат был минимальным
+    std::vector<const Stop*> by_size = stops;
+    std::sort(by_size.begin(), by_size.end(), [](const Stop* lhs, const Stop* rhs) {
+        return lhs->bus_ids.size() < rhs->bus_ids.size();
+    });
+
+    std::vector<uint32_t> common = by_size.front()->bus_ids;
+    std::vector<uint32_t> buffer;
+    for (size_t i = 1; i < by_size.size() && !common.empty(); ++i) {
+        IntersectSorted(common, by_size[i]->bus_ids, buffer);
+        common.swap(buffer);
+    }
+
+    std::vector<std::string_view> result;
+    result.reserve(common.size());
+    for (const uint32_t bus_id : common) {
+        result.push_back(sorted_buses_[bus_id]->number);
+    }
+    return result;
+}
+
+void TransportCatalogue::BuildNameIndex() {
+    // При повторном добавлении имени в индекс попадает тот объект, который возвращал поиск по словарю
+    std::vector<std::pair<std::string_view, uint32_t>> stop_keys;
+    stop_keys.reserve(stopname_to_stop_.size());
+    for (size_t i = 0; i < all_stops_.size(); ++i) {
+        if (stopname_to_stop_.at(all_stops_[i].name) == &all_stops_[i]) {
+            stop_keys.emplace_back(all_stops_[i].name, static_cast<uint32_t>(i));
+        }
+    }
+    std::vector<std::pair<std::string_view, uint32_t>> bus_keys;
+    bus_keys.reserve(busname_to_bus_.size());
+    for (size_t i = 0; i < all_buses_.size(); ++i) {
+        if (busname_to_bus_.at(all_buses_[i].number) == &all_buses_[i]) {
+            bus_keys.emplace_back(all_buses_[i].number, static_cast<uint32_t>(i));
+        }
+    }
+    SetNameIndex(PerfectHash(stop_keys), PerfectHash(bus_keys));
+}
+
+void TransportCatalogue::SetNameIndex(PerfectHash stop_names, PerfectHash bus_names) {
+    stop_names_ = std::move(stop_names);
+    bus_names_ = std::move(bus_names);
+}
+
+const PerfectHash& TransportCatalogue::GetStopNameIndex() const {
+    return stop_names_;
+}
+
+const PerfectHash& TransportCatalogue::GetBusNameIndex() const {
+    return bus_names_;
+}
+
+void TransportCatalogue::BuildSearchIndex() {
+    std::vector<std::pair<std::string_view, uint32_t>> stop_keys;
+    stop_keys.reserve(stopname_to_stop_.size());
+    for (size_t i = 0; i < all_stops_.size(); ++i) {
+        if (stopname_to_stop_.at(all_stops_[i].name) == &all_stops_[i]) {
+            stop_keys.emplace_back(all_stops_[i].name, static_cast<uint32_t>(i));
+        }
+    }
+    SetSearchIndex(NameTrie(std::move(stop_keys)));
+}
+
+void TransportCatalogue::SetSearchIndex(NameTrie stop_search) {
+    stop_search_ = std::move(stop_search);
+}
+
+const NameTrie& TransportCatalogue::GetSearchIndex() const {
+    return stop_search_;
+}
+
+std::vector<std::pair<const Stop*, uint32_t>> TransportCatalogue::SearchStops(std::string_view query, uint32_t max_edits, size_t limit) const {
+    std::vector<std::pair<const Stop*, uint32_t>> result;
+    for (const auto& [stop_id, edits] : stop_search_.Search(query, max_edits, limit)) {
+        result.emplace_back(&all_stops_[stop_id], edits);
+    }
+    return result;
+}
+
+void TransportCatalogue::FillRouteDistances(Bus& bus) const {
+    const size_t stops_count = bus.stops.size();
+    bus.forward_distances.assign(stops_count, 0);
+    bus.backward_distances.assign(stops_count, 0);
+    bus.geo_distances.assign(stops_count, 0.0);
+    for (size_t i = 1; i < stops_count; ++i) {
+        const Stop* from = bus.stops[i - 1];
+        const Stop* to = bus.stops[i];
+        bus.forward_distances[i] = bus.forward_distances[i - 1] + GetDistance(from, to);
+        bus.backward_distances[i] = bus.backward_distances[i - 1] + GetDistance(to, from);
+        bus.geo_distances[i] = bus.geo_distances[i - 1] + geo::ComputeDistance(from->coordinates, to->coordinates);
+    }
+
+    bus.stop_positions.clear();
+    bus.stop_positions.reserve(stops_count);
+    for (size_t i = 0; i < stops_count; ++i) {
+        bus.stop_positions.emplace_back(bus.stops[i], static_cast<uint32_t>(i));
+    }
+    std::sort(bus.stop_positions.begin(), bus.stop_positions.end(), StopPositionLess);
+}
+
+std::vector<geo::Coordinates> TransportCatalogue::GetStopsCoordinates() const {
+    std::vector<geo::Coordinates> result;
+    result.reserve(all_stops_.size());
+    for (const auto& stop : all_stops_) {
+        result.push_back(stop.coordinates);
+    }
+    return result;
+}
+
 }  // namespace transport
\ No newline at end of file
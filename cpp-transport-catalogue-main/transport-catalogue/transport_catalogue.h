@@ -2,6 +2,10 @@
 
 #include "geo.h"
 #include "domain.h"
+#include "name_trie.h"
+#include "perfect_hash.h"
+#include "spatial_index.h"
+#include "string_arena.h"
 
 #include <iostream>
 #include <deque>
@@ -26,6 +30,8 @@ public:
         }
     };
 
+    // Резервирует словари под известное заранее число объектов, чтобы загрузка шла без перехеширования
+    void Reserve(size_t stop_count, size_t bus_count, size_t distance_count);
     void AddStop(std::string_view stop_name, const geo::Coordinates coordinates);
     void AddRoute(std::string_view bus_number, const std::vector<const Stop*> stops, bool is_circle);
     const Bus* FindRoute(std::string_view bus_number) const;
@@ -33,17 +39,58 @@ public:
     size_t UniqueStopsCount(std::string_view bus_number) const;
     void SetDistance(const Stop* from, const Stop* to, const int distance);
     int GetDistance(const Stop* from, const Stop* to) const;
-    const std::map<std::string_view, const Bus*> GetSortedAllBuses() const;
-    const std::map<std::string_view, const Stop*> GetSortedAllStops() const;
+    // Строит все индексы: сначала отсортированные списки, затем независимые индексы параллельно
+    void Finalize();
+    // Отсортированные по имени списки доступны после BuildSortedIndex
+    void BuildSortedIndex();
+    BusesRange GetSortedAllBuses() const;
+    StopsRange GetSortedAllStops() const;
     const std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopDistancesHasher> GetStopDistances() const;
     std::optional<transport::BusStat> GetBusStat(const std::string_view bus_number) const;
+    std::optional<transport::RouteSegmentStat> GetRouteSegmentStat(std::string_view bus_number, std::string_view stop_from, std::string_view stop_to) const;
+    const std::deque<Stop>& GetAllStops() const;
+    const std::deque<Bus>& GetAllBuses() const;
+    std::string_view InternName(std::string_view name);
+
+    void BuildStopIndex();
+    // Несогласованная с остановками сетка отбрасывается, и индекс строится по координатам остановок
+    void SetStopIndex(geo::SpatialIndex::Grid grid);
+    const geo::SpatialIndex& GetStopIndex() const;
+    std::vector<std::pair<const Stop*, double>> FindNearestStops(geo::Coordinates center, double radius, size_t limit) const;
+
+    // Списки маршрутов по остановкам строятся после BuildSortedIndex
+    void BuildBusIndex();
+    void SetBusIndex(std::vector<std::vector<uint32_t>> bus_ids_by_stop);
+    std::vector<std::string_view> GetBusesByStop(const Stop* stop) const;
+    std::vector<std::string_view> GetCommonBuses(const std::vector<const Stop*>& stops) const;
+
+    void BuildNameIndex();
+    void SetNameIndex(PerfectHash stop_names, PerfectHash bus_names);
+    const PerfectHash& GetStopNameIndex() const;
+    const PerfectHash& GetBusNameIndex() const;
+
+    void BuildSearchIndex();
+    void SetSearchIndex(NameTrie stop_search);
+    const NameTrie& GetSearchIndex() const;
+    std::vector<std::pair<const Stop*, uint32_t>> SearchStops(std::string_view query, uint32_t max_edits, size_t limit) const;
 
 private:
+    StringArena names_;
     std::deque<Bus> all_buses_;
     std::deque<Stop> all_stops_;
     std::unordered_map<std::string_view, const Bus*> busname_to_bus_;
     std::unordered_map<std::string_view, const Stop*> stopname_to_stop_;
     std::unordered_map<std::pair<const Stop*, const Stop*>, int, StopDistancesHasher> stop_distances_;
+    std::vector<const Bus*> sorted_buses_;
+    std::vector<const Stop*> sorted_stops_;
+    geo::SpatialIndex stop_index_;
+    PerfectHash stop_names_;
+    PerfectHash bus_names_;
+    NameTrie stop_search_;
+
+    std::vector<geo::Coordinates> GetStopsCoordinates() const;
+    // Заполняет накопленные длины маршрута и позиции его остановок
+    void FillRouteDistances(Bus& bus) const;
 };
 
 }  // namespace transport
\ No newline at end of file
@@ -2,9 +2,8 @@
 
 namespace transport {
     
-void Router::AddStopsToGraph(const TransportCatalogue& catalogue, graph::DirectedWeightedGraph<double>& stops_graph, std::map<std::string, graph::VertexId>& stop_ids, int& vertex_id) {
-    const auto& all_stops = catalogue.GetSortedAllStops();
-    for (const auto& [stop_name, stop_info] : all_stops) {
+void Router::AddStopsToGraph(const TransportCatalogue& catalogue, graph::DirectedWeightedGraph<double>& stops_graph, std::map<std::string_view, graph::VertexId>& stop_ids, graph::VertexId& vertex_id) {
+    for (const Stop* stop_info : catalogue.GetSortedAllStops()) {
         stop_ids[stop_info->name] = vertex_id;
         stops_graph.AddEdge({
             stop_info->name,
@@ -17,21 +16,16 @@ void Router::AddStopsToGraph(const TransportCatalogue& catalogue, graph::Directe
     }
 }
 
-void Router::AddBusesToGraph(const TransportCatalogue& catalogue, graph::DirectedWeightedGraph<double>& stops_graph, const std::map<std::string, graph::VertexId>& stop_ids) {
-    const auto& all_buses = catalogue.GetSortedAllBuses();
-    for (const auto& [bus_number, bus_info] : all_buses) {
+void Router::AddBusesToGraph(const TransportCatalogue& catalogue, graph::DirectedWeightedGraph<double>& stops_graph, const std::map<std::string_view, graph::VertexId>& stop_ids) {
+    for (const Bus* bus_info : catalogue.GetSortedAllBuses()) {
         const auto& stops = bus_info->stops;
         size_t stops_count = stops.size();
         for (size_t i = 0; i < stops_count; ++i) {
             for (size_t j = i + 1; j < stops_count; ++j) {
                 const Stop* stop_from = stops[i];
                 const Stop* stop_to = stops[j];
-                int dist_sum = 0;
-                int dist_sum_inverse = 0;
-                for (size_t k = i + 1; k <= j; ++k) {
-                    dist_sum += catalogue.GetDistance(stops[k - 1], stops[k]);
-                    dist_sum_inverse += catalogue.GetDistance(stops[k], stops[k - 1]);
-                }
+                const int dist_sum = bus_info->forward_distances[j] - bus_info->forward_distances[i];
+                const int dist_sum_inverse = bus_info->backward_distances[j] - bus_info->backward_distances[i];
                 stops_graph.AddEdge({
                     bus_info->number,
                     j - i,
@@ -54,38 +48,61 @@ void Router::AddBusesToGraph(const TransportCatalogue& catalogue, graph::Directe
 }
 
 const graph::DirectedWeightedGraph<double>& Router::BuildGraph(const TransportCatalogue& catalogue) {
-    const auto& all_stops = catalogue.GetSortedAllStops();
-    graph::DirectedWeightedGraph<double> stops_graph(all_stops.size() * 2);
-    std::map<std::string, graph::VertexId> stop_ids;
+    const auto all_stops = catalogue.GetSortedAllStops();
+    graph::DirectedWeightedGraph<double> stops_graph(std::distance(all_stops.begin(), all_stops.end()) * 2);
+    std::map<std::string_view, graph::VertexId> stop_ids;
     graph::VertexId vertex_id = 0;
     AddStopsToGraph(catalogue, stops_graph, stop_ids, vertex_id);
     AddBusesToGraph(catalogue, stops_graph, stop_ids);
     stop_ids_ = std::move(stop_ids);
-    const auto& all_buses = catalogue.GetSortedAllBuses();
     graph_ = std::move(stops_graph);
     router_ = std::make_unique<graph::Router<double>>(graph_);
     return graph_;
 }
 
 const std::optional<graph::Router<double>::RouteInfo> Router::FindRoute(const std::string_view stop_from, const std::string_view stop_to) const {
-    return router_->BuildRoute(stop_ids_.at(std::string(stop_from)), stop_ids_.at(std::string(stop_to)));
+    return router_->BuildRoute(stop_ids_.at(stop_from), stop_ids_.at(stop_to));
+}
+
+const std::optional<WalkingRouteInfo> Router::FindRoute(const std::vector<std::pair<std::string_view, double>>& origins, const std::vector<std::pair<std::string_view, double>>& destinations) const {
+    auto to_vertices = [this](const std::vector<std::pair<std::string_view, double>>& stops) {
+        std::vector<std::pair<graph::VertexId, double>> result;
+        result.reserve(stops.size());
+        for (const auto& [stop_name, walk_time] : stops) {
+            result.emplace_back(stop_ids_.at(stop_name), walk_time);
+        }
+        return result;
+    };
+
+    const auto route = router_->BuildRoute(to_vertices(origins), to_vertices(destinations));
+    if (!route) {
+        return std::nullopt;
+    }
+    return WalkingRouteInfo{
+        route->weight,
+        origins[route->source_index].first,
+        origins[route->source_index].second,
+        route->edges,
+        destinations[route->target_index].first,
+        destinations[route->target_index].second
+    };
 }
 
 const graph::DirectedWeightedGraph<double>& Router::GetGraph() const {
     return graph_;
 }
 
-void Router::SetGraph(const graph::DirectedWeightedGraph<double> graph, const std::map<std::string, graph::VertexId> stop_ids) {
+void Router::SetGraph(const graph::DirectedWeightedGraph<double> graph, const std::map<std::string_view, graph::VertexId> stop_ids) {
     graph_ = graph;
     stop_ids_ = stop_ids;
     router_ = std::make_unique<graph::Router<double>>(graph_);
 }
 
-const int Router::GetBusWaitTime() const {
+int Router::GetBusWaitTime() const {
     return settings_.bus_wait_time;
 }
 
-const double Router::GetBusVelocity() const {
+double Router::GetBusVelocity() const {
     return settings_.bus_velocity;
 }
 
@@ -93,7 +110,7 @@ const Router Router::GetRouterSettings() const {
     return { settings_.bus_wait_time, settings_.bus_velocity };
 }
 
-const std::map<std::string, graph::VertexId> Router::GetStopIds() const {
+const std::map<std::string_view, graph::VertexId> Router::GetStopIds() const {
     return stop_ids_;
 }
     
@@ -6,29 +6,38 @@
 #include <memory>
 
 namespace transport {
+
+struct WalkingRouteInfo {
+    double total_time = 0.0;
+    std::string_view origin_stop;
+    double origin_walk_time = 0.0;
+    std::vector<graph::EdgeId> edges;
+    std::string_view destination_stop;
+    double destination_walk_time = 0.0;
+};
+
 class Router {
 public:
     Router(const int bus_wait_time, const double bus_velocity)
         : settings_{ bus_wait_time, bus_velocity } {
-        BuildGraph(catalogue);
     }
 
-    Router(const Router& settings, graph::DirectedWeightedGraph<double> graph, std::map<std::string, graph::VertexId> stop_ids)
-        : bus_wait_time_(settings.settings_.bus_wait_time)
-        , bus_velocity_(settings.settings_.bus_velocity)
-        , graph_(graph)
-        , stop_ids_(stop_ids) {
+    Router(const Router& settings, graph::DirectedWeightedGraph<double> graph, std::map<std::string_view, graph::VertexId> stop_ids)
+        : graph_(graph)
+        , stop_ids_(stop_ids)
+        , settings_(settings.settings_) {
         router_ = std::make_unique<graph::Router<double>>(graph_);
     }
 
     const graph::DirectedWeightedGraph<double>& BuildGraph(const TransportCatalogue& catalogue);
     const std::optional<graph::Router<double>::RouteInfo> FindRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+    const std::optional<WalkingRouteInfo> FindRoute(const std::vector<std::pair<std::string_view, double>>& origins, const std::vector<std::pair<std::string_view, double>>& destinations) const;
     const graph::DirectedWeightedGraph<double>& GetGraph() const;
-    void SetGraph(const graph::DirectedWeightedGraph<double> graph, const std::map<std::string, graph::VertexId> stop_ids);
-    const int GetBusWaitTime() const;
-    const double GetBusVelocity() const;
+    void SetGraph(const graph::DirectedWeightedGraph<double> graph, const std::map<std::string_view, graph::VertexId> stop_ids);
+    int GetBusWaitTime() const;
+    double GetBusVelocity() const;
     const Router GetRouterSettings() const;
-    const std::map<std::string, graph::VertexId> GetStopIds() const;
+    const std::map<std::string_view, graph::VertexId> GetStopIds() const;
 
 private:
     struct Settings {
@@ -36,10 +45,10 @@ private:
         double bus_velocity = 0.0;
     };
 
-    void AddBusesToGraph(const TransportCatalogue& catalogue, graph::DirectedWeightedGraph<double>& stops_graph, const std::map<std::string, graph::VertexId>& stop_ids);
-    void AddStopsToGraph(const TransportCatalogue& catalogue, graph::DirectedWeightedGraph<double>& stops_graph, std::map<std::string, graph::VertexId>& stop_ids, int& vertex_id);
+    void AddBusesToGraph(const TransportCatalogue& catalogue, graph::DirectedWeightedGraph<double>& stops_graph, const std::map<std::string_view, graph::VertexId>& stop_ids);
+    void AddStopsToGraph(const TransportCatalogue& catalogue, graph::DirectedWeightedGraph<double>& stops_graph, std::map<std::string_view, graph::VertexId>& stop_ids, graph::VertexId& vertex_id);
     graph::DirectedWeightedGraph<double> graph_;
-    std::map<std::string, graph::VertexId> stop_ids_;
+    std::map<std::string_view, graph::VertexId> stop_ids_;
     std::unique_ptr<graph::Router<double>> router_;
     Settings settings_;
 };